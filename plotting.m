@@ -1,20 +1,26 @@
 close all;
-depth = [4,6,8,10,12];
-% without multithreading, pure processing time
-times_ms = [15,200,3500,34500,267750]/1000;
-times_threading = [18,100,2000,20500, 195500]/1000;
+% search times written by the benchmark suite: connect4_bench --csv bench.csv
+data = readtable('bench.csv');
+search = data(strcmp(data.suite, 'search'), :);
+depth = unique(search.depth);
+threads = unique(search.threads);
+
+% python implementation, one game measured once by hand
+depth_python = [4,6,8];
 times_python = [4100, 40500, 796000]/1000;
 
-semilogy (depth(1:3), times_python, 'linewidth', 1.5)
+semilogy (depth_python, times_python, 'linewidth', 1.5)
 hold on
-semilogy (depth, times_ms, 'linewidth', 1.5)
-semilogy (depth, times_threading, 'linewidth', 1.5)
+names = {'python'};
+for t = threads'
+    rows = search(search.threads == t, :);
+    % total time over the corpus per depth
+    times = arrayfun(@(d) sum(rows.time_ms(rows.depth == d)), depth) / 1000;
+    semilogy (depth, times, 'linewidth', 1.5)
+    names{end+1} = sprintf('c++ %d threads', t);
+end
 xlabel('depth')
 ylabel('processing time [s]')
 grid on
 
-
-
-
-
-legend('python', 'c++ baseline', 'c++ thread', 'location', 'southeast')
+legend(names, 'location', 'southeast')
@@ -0,0 +1,785 @@
+/**
+* @brief    Benchmark suite of the engine: time to depth of Ai::get_move over a fixed corpus, micro benchmarks of the
+*           board operations, node counts with and without move ordering, speedup over the number of threads
+* @file     bench.cpp
+*
+* usage: connect4_bench [suite] [--depth N] [--threads N,M,..] [--repeat N] [--csv file] [--json file]
+*                       [--compare baseline.csv] [--tolerance percent]
+*        connect4_bench ordering [max_depth]
+*        connect4_bench symmetry [depth]
+*        connect4_bench threads [depth] [max_threads]
+*        connect4_bench eval [max_depth] [openings]
+*        connect4_bench stress [resets] [depth] [budget_ms]
+*        connect4_bench evalcheck [games]
+*
+* The suite writes one record per measurement. Search records hold the median wall time of --repeat runs,
+* micro records count operations in nodes, evaluated boards for the batch evaluation. With --compare the records are checked against a csv written
+* by an earlier run, the exit code is 2 if any of them got slower than the tolerance or searched more nodes.
+* stress cancels searches, resets and destroys games mid-search, the exit code is 2 if one of them or a call on a game took longer than
+* budget_ms (STOP_BUDGET_MS by default). The engine guarantees the work, not the time: a cancelled search returns after at most
+* STOP_CHECK_NODES nodes of the main thread, and the calls on a game only queue a command. The time to wake and join the search thread
+* is up to the scheduler. In a release build on a host with a free core every latency stays below STOP_BUDGET_MS, on a single shared
+* core single resets took up to 10 ms (3 of 2000 in a debug build), so ctest runs stress with a budget of 25 ms.
+* evalcheck compares the incremental eval with eval_reference after every drop and undo, the exit code is 2 if they differ.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai.h"
+#include "board_batch.h"
+#include "game.h"
+
+namespace {
+
+//fixed positions as sequences of played columns 1..7, player 1 starts
+const std::vector<std::string> POSITIONS = {
+    "",
+    "4453",
+    "44444433",
+    "3343452",
+    "42563214",
+    "1234567712",
+};
+
+//corpus of the suite, opening, middlegame and endgame positions
+const std::vector<std::pair<std::string, std::string>> CORPUS = {
+    {"opening-empty", ""},
+    {"opening-1", "4453"},
+    {"opening-2", "3343452"},
+    {"middle-1", "42563214"},
+    {"middle-2", "1234567712"},
+    {"middle-3", "1213472451521624"},
+    {"end-1", "336675211354616521477455"},
+    {"end-2", "2261674354242135112741327633"},
+};
+
+struct Run {
+    int move;
+    int score;
+    uint64_t nodes;
+    long long ms;
+    double knps;
+    std::size_t entries;    //positions in the transposition table after the search
+};
+
+//one measurement of the suite, for micro benchmarks nodes counts operations
+struct Record {
+    std::string suite;
+    std::string name;
+    int depth;
+    int threads;
+    int move;
+    int score;
+    uint64_t nodes;
+    double time_ms;
+    double nodes_per_sec;
+};
+
+Board make_board(const std::string &moves, int &player){
+    Board board;
+    player = 1;
+    for(char c : moves){
+        board.drop(c - '1', player);
+        player = 3 - player;
+    }
+    return board;
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point t_start){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t_start).count() / 1e6;
+}
+
+Run run(const std::string &moves, int depth, bool ordering, int threads, bool symmetry = true){
+    int player;
+    Board board = make_board(moves, player);
+
+    Ai ai(depth, player);
+    ai.set_move_ordering(ordering);
+    ai.set_symmetry(symmetry);
+    ai.set_threads(threads);
+    auto t_start = std::chrono::steady_clock::now();
+    std::pair<int, int> result = ai.get_move(board);
+    auto t_end = std::chrono::steady_clock::now();
+
+    Run r;
+    r.move = result.first;
+    r.score = result.second;
+    r.nodes = ai.get_nodes();
+    r.ms = std::chrono::duration_cast<std::chrono::milliseconds>(t_end - t_start).count();
+    r.knps = double(r.nodes) / std::max(1.0, double(std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_start).count())) * 1000.0;
+    r.entries = ai.get_tt_entries();
+    return r;
+}
+
+//time to depth for 1..max_threads threads per position
+int bench_threads(int depth, int max_threads){
+    //more search threads than cores share them, their speedup says nothing about the parallel search
+    int cores = int(std::max(1u, std::thread::hardware_concurrency()));
+    std::printf("hardware threads: %d%s\n", cores, (max_threads > cores)? ", rows marked * are oversubscribed" : "");
+    std::printf("%-12s %5s %8s %12s %8s %9s %7s\n", "position", "depth", "threads", "nodes", "overhead", "ms", "speedup");
+    for(const auto &moves : POSITIONS){
+        double ms_single = 0;
+        double nodes_single = 0;
+        for(int threads = 1; threads <= max_threads; ++threads){
+            Run r = run(moves, depth, true, threads);
+            double ms = std::max(1.0, double(r.ms));
+            if(threads == 1){
+                ms_single = ms;
+                nodes_single = double(std::max<uint64_t>(1, r.nodes));
+            }
+            std::printf("%-12s %5d %7d%s %12llu %8.2f %9lld %7.2f\n", moves.empty()? "-" : moves.c_str(), depth, threads,
+                        (threads > cores)? "*" : " ", (unsigned long long)r.nodes, double(r.nodes) / nodes_single,
+                        r.ms, ms_single / ms);
+        }
+    }
+    return 0;
+}
+
+//node counts with and without move ordering, both must find the same move and score
+int bench_ordering(int max_depth){
+    std::printf("%-12s %5s %12s %12s %7s %9s %9s %10s %s\n",
+                "position", "depth", "nodes_plain", "nodes_order", "ratio", "ms_plain", "ms_order", "knps", "result");
+    bool all_equal = true;
+    for(const auto &moves : POSITIONS){
+        for(int depth = 8; depth <= max_depth; depth += 2){
+            Run plain = run(moves, depth, false, 1);
+            Run ordered = run(moves, depth, true, 1);
+            bool equal = plain.move == ordered.move && plain.score == ordered.score;
+            all_equal = all_equal && equal;
+            std::printf("%-12s %5d %12llu %12llu %7.1f %9lld %9lld %10.0f %s\n",
+                        moves.empty()? "-" : moves.c_str(), depth,
+                        (unsigned long long)plain.nodes, (unsigned long long)ordered.nodes,
+                        double(plain.nodes) / double(ordered.nodes), plain.ms, ordered.ms,
+                        plain.knps, equal? "same" : "DIFFERENT");
+        }
+    }
+    return all_equal? 0 : 1;
+}
+
+//node counts and table entries with and without the symmetry reduction, both must find the same move and score
+int bench_symmetry(int depth){
+    std::printf("%-14s %5s %12s %12s %7s %12s %12s %7s %s\n",
+                "position", "depth", "nodes_plain", "nodes_sym", "ratio", "tt_plain", "tt_sym", "ratio", "result");
+    bool all_equal = true;
+    uint64_t total_plain = 0;
+    uint64_t total_sym = 0;
+    std::size_t entries_plain = 0;
+    std::size_t entries_sym = 0;
+    for(const auto &position : CORPUS){
+        Run plain = run(position.second, depth, true, 1, false);
+        Run sym = run(position.second, depth, true, 1, true);
+        bool equal = plain.move == sym.move && plain.score == sym.score;
+        all_equal = all_equal && equal;
+        total_plain += plain.nodes;
+        total_sym += sym.nodes;
+        entries_plain += plain.entries;
+        entries_sym += sym.entries;
+        std::printf("%-14s %5d %12llu %12llu %7.2f %12zu %12zu %7.2f %s\n", position.first.c_str(), depth,
+                    (unsigned long long)plain.nodes, (unsigned long long)sym.nodes, double(plain.nodes) / double(std::max<uint64_t>(1, sym.nodes)),
+                    plain.entries, sym.entries, double(plain.entries) / double(std::max<std::size_t>(1, sym.entries)),
+                    equal? "same" : "DIFFERENT");
+    }
+    std::printf("%-14s %5d %12llu %12llu %7.2f %12zu %12zu %7.2f\n", "total", depth,
+                (unsigned long long)total_plain, (unsigned long long)total_sym, double(total_plain) / double(std::max<uint64_t>(1, total_sym)),
+                entries_plain, entries_sym, double(entries_plain) / double(std::max<std::size_t>(1, entries_sym)));
+    return all_equal? 0 : 1;
+}
+
+/**
+ * @brief search_records    : times get_move with a fresh ai for every corpus position, depth and thread count
+ * @param max_depth         : depths 4, 6, .. max_depth are searched
+ * @param threads           : thread counts to measure
+ * @param repeat            : runs per measurement, the median time is kept
+ * @return
+ */
+std::vector<Record> search_records(int max_depth, const std::vector<int> &threads, int repeat){
+    std::vector<Record> records;
+    for(const auto &position : CORPUS){
+        int player;
+        Board board = make_board(position.second, player);
+        for(int depth = 4; depth <= max_depth; depth += 2){
+            for(int n_threads : threads){
+                std::vector<double> times;
+                Record record = {"search", position.first, depth, n_threads, -1, 0, 0, 0.0, 0.0};
+                for(int i = 0; i < repeat; ++i){
+                    Ai ai(depth, player);
+                    ai.set_threads(n_threads);
+                    auto t_start = std::chrono::steady_clock::now();
+                    std::pair<int, int> result = ai.get_move(board);
+                    times.push_back(elapsed_ms(t_start));
+                    if(i == 0){
+                        record.move = result.first;
+                        record.score = result.second;
+                        record.nodes = ai.get_nodes();
+                    }
+                }
+                std::sort(times.begin(), times.end());
+                record.time_ms = times[times.size() / 2];
+                record.nodes_per_sec = double(record.nodes) / std::max(1e-6, record.time_ms / 1000.0);
+                records.push_back(record);
+            }
+        }
+    }
+    return records;
+}
+
+//random positions which are not decided yet, as input of the micro benchmarks
+std::vector<std::pair<Board, int>> random_positions(std::size_t count){
+    std::mt19937 rng(42);
+    std::vector<std::pair<Board, int>> positions;
+    while(positions.size() < count){
+        Board board;
+        int player = 1;
+        int stones = int(rng() % (Board::WIDTH * Board::HEIGHT - 6));
+        while(board.get_moves() < stones){
+            std::vector<int> drops = board.possible_drops();
+            int col = drops[rng() % drops.size()];
+            board.drop(col, player);
+            if(board.is_game_over(player)){
+                board.undo(col);
+                break;
+            }
+            player = 3 - player;
+        }
+        positions.push_back({board, player});
+    }
+    return positions;
+}
+
+/**
+ * @brief micro_record  : repeats op over all positions for at least 200 ms
+ * @param name          : name of the record
+ * @param op            : performs its operations on one position and returns how many it did
+ * @return
+ */
+template<typename Op>
+Record micro_record(const std::string &name, std::vector<std::pair<Board, int>> &positions, Op op){
+    uint64_t ops = 0;
+    double ms = 0;
+    auto t_start = std::chrono::steady_clock::now();
+    do{
+        for(auto &position : positions){
+            ops += op(position.first, position.second);
+        }
+        ms = elapsed_ms(t_start);
+    }while(ms < 200.0);
+    return Record{"micro", name, 0, 1, -1, 0, ops, ms, double(ops) / (ms / 1000.0)};
+}
+
+std::vector<Record> micro_records(){
+    std::vector<std::pair<Board, int>> positions = random_positions(4096);
+    //results flow into sink so the compiler can't drop the calls
+    volatile int sink = 0;
+    std::vector<Record> records;
+    records.push_back(micro_record("drop_undo", positions, [&](Board &board, int player){
+        Board::movelist drops;
+        int n = board.possible_drops(drops);
+        for(int i = 0; i < n; ++i){
+            board.drop(drops[i], player);
+            board.undo(drops[i]);
+        }
+        return n;
+    }));
+    records.push_back(micro_record("is_winner", positions, [&](Board &board, int){
+        sink = sink + board.is_winner(1) + board.is_winner(2);
+        return 2;
+    }));
+    records.push_back(micro_record("eval", positions, [&](Board &board, int player){
+        sink = sink + board.eval(player, 5000, -5000, 0);
+        return 1;
+    }));
+    records.push_back(micro_record("possible_drops", positions, [&](Board &board, int){
+        Board::movelist drops;
+        sink = sink + board.possible_drops(drops);
+        return 1;
+    }));
+    records.push_back(micro_record("possible_drops_vector", positions, [&](Board &board, int){
+        sink = sink + int(board.possible_drops().size());
+        return 1;
+    }));
+
+    //batch evaluation of all positions per call, nodes are evaluated boards
+    BoardBatch batch;
+    for(const auto &position : positions){
+        batch.add(position.first, position.second);
+    }
+    std::vector<int> scores(batch.size());
+    for(BoardBatch::Kernel kernel : {BoardBatch::SCALAR, BoardBatch::SSE4, BoardBatch::AVX2}){
+        if(!BoardBatch::is_supported(kernel)){
+            continue;
+        }
+        uint64_t boards = 0;
+        double ms = 0;
+        auto t_start = std::chrono::steady_clock::now();
+        do{
+            batch.eval(5000, -5000, 0, scores.data(), kernel);
+            sink = sink + scores[boards % scores.size()];
+            boards += batch.size();
+            ms = elapsed_ms(t_start);
+        }while(ms < 200.0);
+        records.push_back(Record{"micro", std::string("eval_batch_") + BoardBatch::get_name(kernel), 0, 1, -1, 0,
+                                 boards, ms, double(boards) / (ms / 1000.0)});
+    }
+    return records;
+}
+
+const char CSV_HEADER[] = "suite,name,depth,threads,move,score,nodes,time_ms,nodes_per_sec";
+
+bool write_csv(const std::string &path, const std::vector<Record> &records){
+    std::ofstream out(path);
+    if(!out){
+        return false;
+    }
+    out << CSV_HEADER << "\n";
+    for(const auto &r : records){
+        out << r.suite << "," << r.name << "," << r.depth << "," << r.threads << "," << r.move << "," << r.score << ","
+            << r.nodes << "," << r.time_ms << "," << r.nodes_per_sec << "\n";
+    }
+    return bool(out);
+}
+
+bool write_json(const std::string &path, const std::vector<Record> &records){
+    std::ofstream out(path);
+    if(!out){
+        return false;
+    }
+    out << "{\n  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n  \"records\": [\n";
+    for(std::size_t i = 0; i < records.size(); ++i){
+        const Record &r = records[i];
+        out << "    {\"suite\": \"" << r.suite << "\", \"name\": \"" << r.name << "\", \"depth\": " << r.depth
+            << ", \"threads\": " << r.threads << ", \"move\": " << r.move << ", \"score\": " << r.score
+            << ", \"nodes\": " << r.nodes << ", \"time_ms\": " << r.time_ms << ", \"nodes_per_sec\": " << r.nodes_per_sec
+            << "}" << (i + 1 < records.size()? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return bool(out);
+}
+
+bool read_csv(const std::string &path, std::vector<Record> &records){
+    std::ifstream in(path);
+    std::string line;
+    if(!in || !std::getline(in, line) || line != CSV_HEADER){
+        return false;
+    }
+    while(std::getline(in, line)){
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while(std::getline(stream, field, ',')){
+            fields.push_back(field);
+        }
+        if(fields.size() != 9){
+            return false;
+        }
+        records.push_back(Record{fields[0], fields[1], std::atoi(fields[2].c_str()), std::atoi(fields[3].c_str()),
+                                 std::atoi(fields[4].c_str()), std::atoi(fields[5].c_str()),
+                                 std::strtoull(fields[6].c_str(), nullptr, 10), std::atof(fields[7].c_str()),
+                                 std::atof(fields[8].c_str())});
+    }
+    return true;
+}
+
+/**
+ * @brief compare   : prints the change of every record against the baseline
+ * @param tolerance : allowed slowdown in percent, search times below 1 ms are too noisy and only checked for nodes
+ * @return          : number of regressions
+ */
+int compare(const std::vector<Record> &records, const std::vector<Record> &baseline, double tolerance){
+    std::map<std::string, const Record*> base;
+    auto key = [](const Record &r){
+        return r.suite + "/" + r.name + "/" + std::to_string(r.depth) + "/" + std::to_string(r.threads);
+    };
+    for(const auto &r : baseline){
+        base[key(r)] = &r;
+    }
+
+    int regressions = 0;
+    std::printf("\n%-8s %-22s %5s %7s %12s %9s  %s\n", "suite", "name", "depth", "threads", "nodes", "change", "status");
+    for(const auto &r : records){
+        auto it = base.find(key(r));
+        if(it == base.end()){
+            std::printf("%-8s %-22s %5d %7d %12s %9s  %s\n", r.suite.c_str(), r.name.c_str(), r.depth, r.threads, "-", "-", "new");
+            continue;
+        }
+        const Record &b = *it->second;
+        //micro benchmarks compare throughput, searches wall time and, single threaded, the deterministic node count
+        double change;
+        bool slower;
+        if(r.suite == "micro"){
+            change = (b.nodes_per_sec / std::max(1.0, r.nodes_per_sec) - 1.0) * 100.0;
+            slower = change > tolerance;
+        }
+        else{
+            change = (r.time_ms / std::max(1e-6, b.time_ms) - 1.0) * 100.0;
+            slower = b.time_ms >= 1.0 && change > tolerance;
+        }
+        bool more_nodes = r.suite == "search" && r.threads == 1 && r.nodes > b.nodes;
+        const char *status = "ok";
+        if(slower || more_nodes){
+            status = more_nodes? "REGRESSION (nodes)" : "REGRESSION";
+            ++regressions;
+        }
+        else if(r.suite == "search" && r.threads == 1 && r.nodes != b.nodes){
+            status = "ok (fewer nodes)";
+        }
+        std::printf("%-8s %-22s %5d %7d %12lld %+8.1f%%  %s\n", r.suite.c_str(), r.name.c_str(), r.depth, r.threads,
+                    (long long)r.nodes - (long long)b.nodes, change, status);
+    }
+    std::printf("%d regressions, tolerance %.0f%%\n", regressions, tolerance);
+    return regressions;
+}
+
+std::vector<int> parse_threads(const std::string &list){
+    std::vector<int> threads;
+    std::stringstream stream(list);
+    std::string item;
+    while(std::getline(stream, item, ',')){
+        int n = std::atoi(item.c_str());
+        threads.push_back((n > 0)? n : int(std::max(1u, std::thread::hardware_concurrency())));
+    }
+    return threads;
+}
+
+//result of the games of one pairing, from the side of the threat evaluation
+struct EvalMatch {
+    double points;
+    int games;
+    uint64_t nodes[2];  //positional, threats
+    double ms[2];
+    int moves[2];
+};
+
+/**
+ * @brief play_eval_match   : plays every opening twice with swapped colors, positional eval against threat eval
+ * @param openings          : random starts which are not decided yet
+ * @param depth_positional  : depth of the ai with the positional evaluation
+ * @param depth_threats     : depth of the ai with the threat evaluation
+ * @return
+ */
+EvalMatch play_eval_match(const std::vector<std::string> &openings, int depth_positional, int depth_threats){
+    EvalMatch match = {0.0, 0, {0, 0}, {0.0, 0.0}, {0, 0}};
+    for(const auto &opening : openings){
+        for(int threats_player = 1; threats_player <= 2; ++threats_player){
+            int player;
+            Board board = make_board(opening, player);
+            Ai ai_positional(depth_positional, 3 - threats_player);
+            Ai ai_threats(depth_threats, threats_player);
+            ai_positional.set_threads(1);
+            ai_threats.set_threads(1);
+            ai_threats.set_evaluation(Ai::THREATS);
+
+            double points = 0.5;
+            while(!board.is_full()){
+                int side = (player == threats_player)? 1 : 0;
+                Ai &ai = side? ai_threats : ai_positional;
+                auto t_start = std::chrono::steady_clock::now();
+                int col = ai.get_move(board).first;
+                match.ms[side] += elapsed_ms(t_start);
+                match.nodes[side] += ai.get_nodes();
+                ++match.moves[side];
+                board.drop(col, player);
+                if(board.is_winner(player)){
+                    points = side? 1.0 : 0.0;
+                    break;
+                }
+                player = 3 - player;
+            }
+            match.points += points;
+            ++match.games;
+        }
+    }
+    return match;
+}
+
+//strength per depth and node count of the threat evaluation against the positional one
+int bench_eval(int max_depth, int n_openings){
+    std::mt19937 rng(7);
+    std::vector<std::string> openings;
+    while(int(openings.size()) < n_openings){
+        Board board;
+        int player = 1;
+        std::string moves;
+        bool decided = false;
+        for(int i = 0; i < 4; ++i){
+            std::vector<int> drops = board.possible_drops();
+            int col = drops[rng() % drops.size()];
+            board.drop(col, player);
+            decided = decided || board.is_winner(player);
+            moves += char('1' + col);
+            player = 3 - player;
+        }
+        if(!decided){
+            openings.push_back(moves);
+        }
+    }
+
+    std::printf("%-10s %-9s %6s %9s %16s %16s %12s %12s\n", "positional", "threats", "games", "threats%",
+                "nodes/move pos", "nodes/move thr", "ms/move pos", "ms/move thr");
+    for(int depth = 4; depth <= max_depth; depth += 2){
+        for(int less = 0; less <= 4 && depth - less >= 2; less += 2){
+            EvalMatch m = play_eval_match(openings, depth, depth - less);
+            std::printf("%-10d %-9d %6d %8.1f%% %16.0f %16.0f %12.3f %12.3f\n", depth, depth - less, m.games,
+                        100.0 * m.points / m.games,
+                        double(m.nodes[0]) / std::max(1, m.moves[0]), double(m.nodes[1]) / std::max(1, m.moves[1]),
+                        m.ms[0] / std::max(1, m.moves[0]), m.ms[1] / std::max(1, m.moves[1]));
+        }
+    }
+    return 0;
+}
+
+//plays the moves, then random moves until the game is decided, and takes all of them back again. Compares the
+//incremental eval of both players with eval_reference after every drop and undo, counts the differences in errors
+//and prints the first one
+template<int W, int H>
+void check_eval_game(const std::string &moves, std::mt19937 &rng, int &errors){
+    BasicBoard<W, H> board;
+    std::vector<int> played;
+    int player = 1;
+    auto check = [&](const char *op){
+        for(int p = 1; p <= 2; ++p){
+            int incremental = board.eval(p, 5000, -5000, 3);
+            int reference = board.eval_reference(p, 5000, -5000, 3);
+            if(incremental != reference){
+                if(errors++ == 0){
+                    std::printf("%dx%d, %s after %zu moves, player %d: eval %d, eval_reference %d\n", W, H, op,
+                                played.size(), p, incremental, reference);
+                }
+            }
+        }
+    };
+
+    check("empty");
+    bool decided = false;
+    for(std::size_t i = 0; !decided && !board.is_full(); ++i){
+        int col;
+        if(i < moves.size()){
+            col = moves[i] - '1';
+        }
+        else{
+            std::vector<int> drops = board.possible_drops();
+            col = drops[rng() % drops.size()];
+        }
+        board.drop(col, player);
+        played.push_back(col);
+        check("drop");
+        decided = board.is_winner(player);
+        player = 3 - player;
+    }
+    while(!played.empty()){
+        board.undo(played.back());
+        played.pop_back();
+        check("undo");
+    }
+}
+
+//eval against eval_reference over the corpus continued randomly and random games on every board size
+int bench_evalcheck(int games){
+    std::mt19937 rng(5);
+    int errors = 0;
+    int played = 0;
+    for(const auto &position : CORPUS){
+        for(int i = 0; i < games / 10 + 1; ++i){
+            check_eval_game<7, 6>(position.second, rng, errors);
+            ++played;
+        }
+    }
+    for(int i = 0; i < games; ++i){
+        check_eval_game<7, 6>("", rng, errors);
+        check_eval_game<8, 7>("", rng, errors);
+        check_eval_game<9, 7>("", rng, errors);
+        played += 3;
+    }
+    std::printf("%d games, %d differences between eval and eval_reference\n", played, errors);
+    return (errors > 0)? 2 : 0;
+}
+
+//latency budget of a cancelled search, a destroyed game or a call on a game
+const double STOP_BUDGET_MS = 5.0;
+
+//observer of the stress games, drops all callbacks
+class NullObserver : public Observer
+{
+public:
+    void updatePositions(Board::boardarray) override {}
+    void updatePossibleDrops(std::vector<int>) override {}
+    void writeToLog(std::string) override {}
+    void updateSearchStats(int, SearchStats) override {}
+    void updateSearchProgress(int, SearchProgress) override {}
+    void gameOver(int) override {}
+    void setWinningLine(std::pair<std::pair<int, int>, std::pair<int, int>>) override {}
+};
+
+//prints max and p99 of the latencies, returns the number over the budget
+int report_latencies(const char *name, std::vector<double> &latencies, double budget_ms){
+    std::sort(latencies.begin(), latencies.end());
+    int over = int(latencies.end() - std::upper_bound(latencies.begin(), latencies.end(), budget_ms));
+    std::printf("%-12s %7zu %10.3f %10.3f %10.3f %6d\n", name, latencies.size(), latencies[latencies.size() / 2],
+                latencies[latencies.size() * 99 / 100], latencies.back(), over);
+    return over;
+}
+
+//cancels searches and destroys games at random times during the search, measures how long they take to stop
+int bench_stress(int resets, int depth, double budget_ms){
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> delay_us(0, 20000);
+
+    //searches of one ai cancelled through its stop token
+    std::vector<double> cancel_ms;
+    for(int i = 0; i < resets; ++i){
+        int player;
+        Board board = make_board(CORPUS[i % CORPUS.size()].second, player);
+        Ai searcher(depth, player, 1);
+        searcher.set_threads(0);
+        StopSource stop;
+        searcher.set_stop_token(stop.get_token());
+        std::thread search([&searcher, &board]{searcher.get_move(board);});
+        std::this_thread::sleep_for(std::chrono::microseconds(delay_us(rng)));
+        auto t_start = std::chrono::steady_clock::now();
+        stop.request_stop();
+        search.join();
+        cancel_ms.push_back(elapsed_ms(t_start));
+    }
+
+    //games against a human reset and destroyed while pondering or during the ai's search,
+    //the calls of the GUI thread only queue a command and must never wait for the worker
+    std::vector<double> reset_ms;
+    std::vector<double> call_ms;
+    NullObserver observer;
+    for(int i = 0; i < resets; ++i){
+        Game *game = new Game(&observer, false, true, depth, depth, 1);
+        game->start();
+        std::this_thread::sleep_for(std::chrono::microseconds(delay_us(rng) / 4));
+        auto t_call = std::chrono::steady_clock::now();
+        game->human_move(int(rng() % Board::WIDTH));
+        call_ms.push_back(elapsed_ms(t_call));
+        std::this_thread::sleep_for(std::chrono::microseconds(delay_us(rng)));
+        if(i % 2){
+            t_call = std::chrono::steady_clock::now();
+            game->reset();
+            game->start();
+            call_ms.push_back(elapsed_ms(t_call));
+            std::this_thread::sleep_for(std::chrono::microseconds(delay_us(rng) / 4));
+        }
+        auto t_start = std::chrono::steady_clock::now();
+        delete game;
+        reset_ms.push_back(elapsed_ms(t_start));
+    }
+
+#ifdef NDEBUG
+    const char *build = "release";
+#else
+    const char *build = "debug";
+#endif
+    //the latencies include waking the search thread, on a busy or oversubscribed host the scheduler adds to them
+    std::printf("hardware threads: %u, %s build, budget %.1f ms\n", std::max(1u, std::thread::hardware_concurrency()), build, budget_ms);
+    std::printf("%-12s %7s %10s %10s %10s %6s\n", "stress", "runs", "median ms", "p99 ms", "max ms", "over");
+    int over = report_latencies("cancel", cancel_ms, budget_ms) + report_latencies("game reset", reset_ms, budget_ms)
+            + report_latencies("game call", call_ms, budget_ms);
+    return over > 0? 2 : 0;
+}
+
+int run_suite(int argc, char *argv[], int first){
+    int max_depth = 12;
+    std::vector<int> threads = {1, int(std::max(1u, std::thread::hardware_concurrency()))};
+    int repeat = 3;
+    double tolerance = 10.0;
+    std::string csv, json, baseline_path;
+    for(int i = first; i + 1 < argc; i += 2){
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if(option == "--depth"){
+            max_depth = std::atoi(value.c_str());
+        }
+        else if(option == "--threads"){
+            threads = parse_threads(value);
+        }
+        else if(option == "--repeat"){
+            repeat = std::max(1, std::atoi(value.c_str()));
+        }
+        else if(option == "--csv"){
+            csv = value;
+        }
+        else if(option == "--json"){
+            json = value;
+        }
+        else if(option == "--compare"){
+            baseline_path = value;
+        }
+        else if(option == "--tolerance"){
+            tolerance = std::atof(value.c_str());
+        }
+        else{
+            std::printf("unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    std::vector<Record> baseline;
+    if(!baseline_path.empty() && !read_csv(baseline_path, baseline)){
+        std::printf("can't read baseline %s\n", baseline_path.c_str());
+        return 1;
+    }
+
+    std::printf("%-8s %-22s %5s %7s %5s %6s %12s %10s %14s\n", "suite", "name", "depth", "threads", "move", "score", "nodes", "ms", "nodes/s");
+    std::vector<Record> records = search_records(max_depth, threads, repeat);
+    std::vector<Record> micro = micro_records();
+    records.insert(records.end(), micro.begin(), micro.end());
+    for(const auto &r : records){
+        std::printf("%-8s %-22s %5d %7d %5d %6d %12llu %10.3f %14.0f\n", r.suite.c_str(), r.name.c_str(), r.depth, r.threads,
+                    r.move, r.score, (unsigned long long)r.nodes, r.time_ms, r.nodes_per_sec);
+    }
+
+    if(!csv.empty() && !write_csv(csv, records)){
+        std::printf("can't write %s\n", csv.c_str());
+        return 1;
+    }
+    if(!json.empty() && !write_json(json, records)){
+        std::printf("can't write %s\n", json.c_str());
+        return 1;
+    }
+    if(!baseline.empty() && compare(records, baseline, tolerance) > 0){
+        return 2;
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    std::string command = (argc > 1)? argv[1] : "suite";
+    if(command == "threads"){
+        int depth = (argc > 2)? std::atoi(argv[2]) : 14;
+        int max_threads = (argc > 3)? std::atoi(argv[3]) : int(std::max(1u, std::thread::hardware_concurrency()));
+        return bench_threads(depth, max_threads);
+    }
+    if(command == "eval"){
+        return bench_eval((argc > 2)? std::atoi(argv[2]) : 10, (argc > 3)? std::atoi(argv[3]) : 20);
+    }
+    if(command == "stress"){
+        return bench_stress((argc > 2)? std::atoi(argv[2]) : 2000, (argc > 3)? std::atoi(argv[3]) : 16,
+                            (argc > 4)? std::atof(argv[4]) : STOP_BUDGET_MS);
+    }
+    if(command == "evalcheck"){
+        return bench_evalcheck((argc > 2)? std::atoi(argv[2]) : 1000);
+    }
+    if(command == "symmetry"){
+        return bench_symmetry((argc > 2)? std::atoi(argv[2]) : 14);
+    }
+    if(command == "ordering"){
+        return bench_ordering((argc > 2)? std::atoi(argv[2]) : 12);
+    }
+    return run_suite(argc, argv, (command == "suite")? 2 : 1);
+}
@@ -0,0 +1,344 @@
+/**
+* @brief    Headless front end of the engine: play against the ai, analyze or solve a position, run ai matches
+* @file     cli.cpp
+*
+* usage: connect4_cli play [human_player=1] [depth=12] [time_ms=0]
+*        connect4_cli analyze <moves> [depth=12] [time_ms=0]
+*        connect4_cli solve <moves>
+*        connect4_cli match <depth_1> <depth_2> [games=2] [time_ms=0] [random_plies=0] [seed=1]
+*        connect4_cli replay <records> [game] [ply]
+*
+* moves are sequences of played columns 1..7, player 1 starts, "-" is the empty board
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "ai.h"
+#include "game_record.h"
+
+namespace {
+
+//opening book used by the ais if it exists in the working directory, see connect4_book
+const char BOOK_FILE[] = "connect4.book";
+
+void print_usage(const char *name){
+    std::printf("usage: %s play [human_player=1] [depth=12] [time_ms=0]\n", name);
+    std::printf("       %s analyze <moves> [depth=12] [time_ms=0]\n", name);
+    std::printf("       %s solve <moves>\n", name);
+    std::printf("       %s match <depth_1> <depth_2> [games=2] [time_ms=0] [random_plies=0] [seed=1]\n", name);
+    std::printf("       %s replay <records> [game] [ply]\n", name);
+    std::printf("moves are the played columns 1..%d, player 1 starts, \"-\" is the empty board\n", Board::WIDTH);
+}
+
+void print_board(const Board &board){
+    auto positions = board.get_positions();
+    for(int row = 0; row < Board::HEIGHT; ++row){
+        std::printf("|");
+        for(int col = 0; col < Board::WIDTH; ++col){
+            const char stones[] = {'.', 'X', 'O'};
+            std::printf(" %c", stones[positions[col][row]]);
+        }
+        std::printf(" |\n");
+    }
+    std::printf("+");
+    for(int col = 0; col < Board::WIDTH; ++col){
+        std::printf("--");
+    }
+    std::printf("-+\n ");
+    for(int col = 0; col < Board::WIDTH; ++col){
+        std::printf(" %d", col + 1);
+    }
+    std::printf("\n");
+}
+
+/**
+ * @brief parse_moves   : plays a move string on an empty board
+ * @param moves         : columns 1..WIDTH, "-" for none
+ * @param board         : resulting board
+ * @param player        : player to move afterwards
+ * @return              : false if a move is invalid or the game is over before the last move
+ */
+bool parse_moves(const std::string &moves, Board &board, int &player){
+    board.reset();
+    player = 1;
+    if(moves == "-"){
+        return true;
+    }
+    for(char c : moves){
+        int col = c - '1';
+        if(col < 0 || col >= Board::WIDTH || board.get_height(col) >= Board::HEIGHT || board.is_game_over(3 - player)){
+            return false;
+        }
+        board.drop(col, player);
+        player = 3 - player;
+    }
+    return true;
+}
+
+long long elapsed_us(std::chrono::steady_clock::time_point t_start){
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start).count();
+}
+
+std::pair<int, int> ai_move(Ai &ai, const Board &board, unsigned time_ms){
+    return (time_ms > 0)? ai.get_move(board, time_ms) : ai.get_move(board);
+}
+
+//human against the ai on stdin/stdout
+int play(int human, int depth, unsigned time_ms){
+    Board board;
+    Ai ai(depth, 3 - human);
+    ai.set_threads(0);
+    ai.load_book(BOOK_FILE);
+    int player = 1;
+    while(true){
+        print_board(board);
+        if(board.is_winner(3 - player)){
+            std::printf("player %d wins\n", 3 - player);
+            return 0;
+        }
+        if(board.is_full()){
+            std::printf("draw\n");
+            return 0;
+        }
+
+        int col;
+        if(player == human){
+            std::printf("your move (1-%d): ", Board::WIDTH);
+            std::fflush(stdout);
+            //the ai searches the replies while the human thinks
+            StopSource stop;
+            StopToken token = stop.get_token();
+            std::future<void> ponder = ThreadPool::instance().submit([&ai, &board, token]{ai.ponder(board, token);});
+            std::string line;
+            bool read = static_cast<bool>(std::getline(std::cin, line));
+            stop.request_stop();
+            ponder.wait();
+            if(!read){
+                return 0;
+            }
+            col = std::atoi(line.c_str()) - 1;
+            if(col < 0 || col >= Board::WIDTH || board.get_height(col) >= Board::HEIGHT){
+                std::printf("invalid move\n");
+                continue;
+            }
+        }
+        else{
+            auto t_start = std::chrono::steady_clock::now();
+            std::pair<int, int> result = ai_move(ai, board, time_ms);
+            col = result.first;
+            std::printf("ai plays %d (score %d, depth %d, %lld ms%s)\n", col + 1, result.second, ai.get_depth_reached(),
+                        elapsed_us(t_start) / 1000, ai.get_search_stats().pondered? ", pondered" : "");
+        }
+        board.drop(col, player);
+        player = 3 - player;
+    }
+}
+
+//best move and score of a position
+int analyze(const std::string &moves, int depth, unsigned time_ms){
+    Board board;
+    int player;
+    if(!parse_moves(moves, board, player) || board.is_game_over(3 - player)){
+        std::printf("invalid position: %s\n", moves.c_str());
+        return 1;
+    }
+    print_board(board);
+
+    Ai ai(depth, player);
+    ai.set_threads(0);
+    ai.set_progress_callback([](const SearchProgress &progress){
+        std::printf("depth %d%s: best %d, score %d, %lld ms, pv", progress.depth, progress.complete? "" : "*",
+                    progress.move + 1, progress.score, progress.time_us / 1000);
+        for(int col : progress.pv){
+            std::printf(" %d", col + 1);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    });
+    Ai::SearchResult result = ai.search(board, time_ms);
+    const SearchStats &stats = result.stats;
+    std::printf("player %d to move\n", player);
+    std::printf("best move: %d\nscore: %d\ndepth: %d\nnodes: %llu\ntime: %lld ms\n", result.move + 1, result.score,
+                stats.depth, (unsigned long long)stats.nodes, stats.time_us / 1000);
+    std::printf("threads:");
+    for(uint64_t nodes : stats.thread_nodes){
+        std::printf(" %llu", (unsigned long long)nodes);
+    }
+    std::printf("\n");
+    if(SearchStats::COUNTERS){
+        std::printf("evals: %llu\ntt cutoffs: %llu\nbeta cutoffs: %llu (%.1f%% first move)\nmax ply: %d\n",
+                    (unsigned long long)stats.leaf_evals, (unsigned long long)stats.tt_cutoffs,
+                    (unsigned long long)stats.beta_cutoffs, stats.first_move_cutoff_rate() * 100.0, stats.max_ply);
+        std::printf("tt hits: %llu of %llu probes\ntt stores: %llu (%llu overwrites)\n",
+                    (unsigned long long)stats.tt_hits, (unsigned long long)(stats.tt_hits + stats.tt_misses),
+                    (unsigned long long)stats.tt_stores, (unsigned long long)stats.tt_overwrites);
+    }
+    return 0;
+}
+
+//exact result of a position
+int solve(const std::string &moves){
+    Board board;
+    int player;
+    if(!parse_moves(moves, board, player) || board.is_game_over(3 - player)){
+        std::printf("invalid position: %s\n", moves.c_str());
+        return 1;
+    }
+    print_board(board);
+
+    Ai ai(1, player);
+    Solver::Result result = ai.solve(board);
+    const char *outcomes[] = {"loss", "draw", "win"};
+    std::printf("player %d to move\n", player);
+    std::printf("result: %s in %d plies\nscore: %d\nbest move: %d\nnodes: %llu\ntime: %lld ms\n", outcomes[result.outcome + 1],
+                result.distance, result.score, result.move + 1, (unsigned long long)result.nodes, result.time_us / 1000);
+    return 0;
+}
+
+//ai against ai, the starting player alternates, optional random opening moves make the games differ
+int match(int depth_1, int depth_2, int games, unsigned time_ms, int random_plies, unsigned seed){
+    std::mt19937 rng(seed);
+    int wins[3] = {0, 0, 0};
+    long long time_total[3] = {0, 0, 0};
+    int moves_total[3] = {0, 0, 0};
+
+    for(int game = 0; game < games; ++game){
+        Ai ai_1(depth_1, 1);
+        Ai ai_2(depth_2, 2);
+        ai_1.set_threads(0);
+        ai_2.set_threads(0);
+        ai_1.load_book(BOOK_FILE);
+        ai_2.load_book(BOOK_FILE);
+
+        Board board;
+        int player = (game % 2 == 0)? 1 : 2;
+        std::string record;
+        int winner = 0;
+        while(!board.is_full()){
+            int col;
+            if(board.get_moves() < random_plies){
+                std::vector<int> drops = board.possible_drops();
+                col = drops[rng() % drops.size()];
+            }
+            else{
+                auto t_start = std::chrono::steady_clock::now();
+                col = ai_move((player == 1)? ai_1 : ai_2, board, time_ms).first;
+                time_total[player] += elapsed_us(t_start);
+                ++moves_total[player];
+            }
+            board.drop(col, player);
+            record += char('1' + col);
+            if(board.is_winner(player)){
+                winner = player;
+                break;
+            }
+            player = 3 - player;
+        }
+        ++wins[winner];
+        std::printf("game %d: %s, moves %s\n", game + 1, winner? (winner == 1? "ai 1 wins" : "ai 2 wins") : "draw", record.c_str());
+    }
+
+    std::printf("ai 1 (depth %d): %d wins, %.1f ms per move\n", depth_1, wins[1], double(time_total[1]) / 1000.0 / std::max(1, moves_total[1]));
+    std::printf("ai 2 (depth %d): %d wins, %.1f ms per move\n", depth_2, wins[2], double(time_total[2]) / 1000.0 / std::max(1, moves_total[2]));
+    std::printf("draws: %d\n", wins[0]);
+    return 0;
+}
+
+//summary of a game record file, or one game of it with the board after ply moves
+int replay(const std::string &path, int game, int ply){
+    GameRecordReader reader;
+    if(!reader.open(path)){
+        std::printf("can't read game records %s\n", path.c_str());
+        return 1;
+    }
+
+    if(game <= 0){
+        auto t_start = std::chrono::steady_clock::now();
+        long long games = 0, plies = 0;
+        long long results[4] = {0, 0, 0, 0};
+        for(auto it = reader.begin(); it != reader.end(); ++it){
+            GameRecordView record = *it;
+            ++games;
+            plies += record.get_plies();
+            ++results[record.get_result() + 1];
+        }
+        long long us = std::max(1LL, elapsed_us(t_start));
+        std::printf("games: %lld (player 1 wins %lld, player 2 wins %lld, draws %lld, unfinished %lld)\n", games,
+                    results[2], results[3], results[1], results[0]);
+        std::printf("average plies: %.1f\nread in %lld ms (%.0f games/s)\n", double(plies) / std::max(1LL, games),
+                    us / 1000, double(games) * 1e6 / double(us));
+        return 0;
+    }
+
+    int index = 1;
+    for(auto it = reader.begin(); it != reader.end(); ++it, ++index){
+        if(index < game){
+            continue;
+        }
+        GameRecordView record = *it;
+        for(int player = 1; player <= 2; ++player){
+            if(record.is_ai(player)){
+                std::printf("player %d: ai, depth %d, budget %u ms\n", player, record.get_depth(player), record.get_budget_ms(player));
+            }
+            else{
+                std::printf("player %d: human\n", player);
+            }
+        }
+        const char *results[] = {"unfinished", "draw", "player 1 wins", "player 2 wins"};
+        std::printf("player %d starts, %s\n", record.get_start(), results[record.get_result() + 1]);
+        for(int i = 0; i < record.get_plies(); ++i){
+            std::printf("%2d. player %d: %d", i + 1, record.get_player(i), record.get_move(i) + 1);
+            if(record.is_ai(record.get_player(i))){
+                std::printf(" (score %d, %u ms)", record.get_score(i), record.get_time_ms(i));
+            }
+            std::printf("\n");
+        }
+        ply = (ply < 0)? record.get_plies() : ply;
+        std::printf("after %d plies:\n", std::min(ply, record.get_plies()));
+        print_board(record.replay(ply));
+        return 0;
+    }
+    std::printf("no game %d in %s\n", game, path.c_str());
+    return 1;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    std::string command = (argc > 1)? argv[1] : "";
+    if(command == "play"){
+        int human = (argc > 2)? std::atoi(argv[2]) : 1;
+        int depth = (argc > 3)? std::atoi(argv[3]) : 12;
+        unsigned time_ms = (argc > 4)? unsigned(std::atoi(argv[4])) : 0;
+        if(human == 1 || human == 2){
+            return play(human, depth, time_ms);
+        }
+    }
+    else if(command == "replay" && argc > 2){
+        return replay(argv[2], (argc > 3)? std::atoi(argv[3]) : 0, (argc > 4)? std::atoi(argv[4]) : -1);
+    }
+    else if(command == "analyze" && argc > 2){
+        int depth = (argc > 3)? std::atoi(argv[3]) : 12;
+        unsigned time_ms = (argc > 4)? unsigned(std::atoi(argv[4])) : 0;
+        return analyze(argv[2], depth, time_ms);
+    }
+    else if(command == "solve" && argc > 2){
+        return solve(argv[2]);
+    }
+    else if(command == "match" && argc > 3){
+        int games = (argc > 4)? std::atoi(argv[4]) : 2;
+        unsigned time_ms = (argc > 5)? unsigned(std::atoi(argv[5])) : 0;
+        int random_plies = (argc > 6)? std::atoi(argv[6]) : 0;
+        unsigned seed = (argc > 7)? unsigned(std::atoi(argv[7])) : 1;
+        return match(std::atoi(argv[2]), std::atoi(argv[3]), games, time_ms, random_plies, seed);
+    }
+    print_usage(argv[0]);
+    return 1;
+}
@@ -1,131 +1,975 @@
 #include "ai.h"
+#include <algorithm>
+#include <cstdlib>
 
+namespace {
 
-Ai::Ai(int depth, int player):
+//tie break of the move ordering, 0 on the edges up to (W - 1) / 2 in the center, the two center columns of an even width are equal
+template<int W>
+constexpr std::array<int, W> make_center_order(){
+    std::array<int, W> order{};
+    for(int col = 0; col < W; ++col){
+        int distance = 2 * col - (W - 1);
+        order[col] = (W - 1 - (distance < 0? -distance : distance)) / 2;
+    }
+    return order;
+}
+
+template<int W>
+constexpr std::array<int, W> CENTER_ORDER = make_center_order<W>();
+
+static_assert(CENTER_ORDER<7>[0] == 0 && CENTER_ORDER<7>[3] == 3 && CENTER_ORDER<7>[5] == 1, "center order of the standard board");
+
+}
+
+
+/**
+ * @brief BasicAi::Ai   : Constructor initializes all member variables, the ai searches on one thread until set_threads
+ * @param depth         : defines the depth for this ai
+ * @param player        : defines the player for this ai
+ * @param tt_size_mb    : size of the transposition table in megabytes
+ */
+template<int W, int H>
+BasicAi<W, H>::BasicAi(int depth, int player, std::size_t tt_size_mb):
     m_depth(depth),
     m_player(player),
     m_winScore(5000),
     m_looseScore(-5000),
-    m_move(-1)
+    m_move(-1),
+    m_tt(tt_size_mb),
+    m_timed(false),
+    m_abort(false),
+    m_stop_helpers(false),
+    m_depth_reached(0),
+    m_pondering(false),
+    m_progress_interval(100),
+    m_ordering(true),
+    m_symmetry(true),
+    m_evaluation(POSITIONAL),
+    m_threads(1)
 {
 }
 
 /**
- * @brief Ai::get_move  : only public method of this class, used to get a move as pair<move, score>
- * @param board         : current board, used to define next step
+ * @brief BasicAi::get_move : only public method of this class, used to get a move as pair<move, score>
+ * @param board             : current board, used to define next step
  * @return
  */
-std::pair<int, int> Ai::get_move(const Board &board){
+template<int W, int H>
+std::pair<int, int> BasicAi<W, H>::get_move(const Board &board){
+    m_timed = false;
+    std::pair<int, int> result;
+    if(probe_ponder(board, result)){
+        return result;
+    }
+    if(probe_book(board, m_depth, result)){
+        return result;
+    }
+    return iterative_deepening(board, m_depth);
+}
 
-    int best_score = max_value(board, m_depth, -10000, 10000);
-    auto result = std::max_element(m_score.begin(), m_score.end());
+/**
+ * @brief BasicAi::get_move : get a move as pair<move, score> within a time budget, deepens until the time is up
+ * @param board             : current board, used to define next step
+ * @param time_ms           : time budget in milliseconds, the move of the deepest finished iteration is returned.
+ *                            A reply pondered to the depth of this ai is returned at once
+ * @return
+ */
+template<int W, int H>
+std::pair<int, int> BasicAi<W, H>::get_move(const Board &board, unsigned time_ms){
+    m_timed = true;
+    m_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_ms);
+    std::pair<int, int> result;
+    if(probe_ponder(board, result)){
+        return result;
+    }
+    if(probe_book(board, 0, result)){
+        return result;
+    }
+    return iterative_deepening(board, Board::WIDTH * Board::HEIGHT - board.get_moves());
+}
+
+/**
+ * @brief BasicAi::search : get_move which also returns the statistics of the search
+ * @param board           : current board, used to define next step
+ * @param time_ms         : time budget in milliseconds, 0 to search to the depth of this ai
+ * @return                : move, score and statistics of the search
+ */
+template<int W, int H>
+typename BasicAi<W, H>::SearchResult BasicAi<W, H>::search(const Board &board, unsigned time_ms){
+    auto t_start = std::chrono::steady_clock::now();
+    std::pair<int, int> move = (time_ms > 0)? get_move(board, time_ms) : get_move(board);
+    m_stats.time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start).count();
+
+    SearchResult result;
+    result.move = move.first;
+    result.score = move.second;
+    result.stats = m_stats;
+    return result;
+}
+
+/**
+ * @brief BasicAi::ponder : searches the replies of the opponent to the depth of this ai while the opponent thinks,
+ *                          the expected reply (best move of the table) first, then the others in the order of the move ordering.
+ *                          The finished ones are answered by get_move without search, the searched nodes stay in the table
+ *                          and speed up the search of a timed get_move or of an interrupted reply
+ * @param board           : board with the opponent to move
+ * @param stop            : stops pondering, checked every STOP_CHECK_NODES nodes
+ */
+template<int W, int H>
+void BasicAi<W, H>::ponder(const Board &board, StopToken stop){
+    for(auto &entry : m_ponder){
+        entry.valid = false;
+    }
+    int opponent = 3 - m_player;
+    int expected = tt_best_move(board);
+    typename Board::movelist replies;
+    int n_replies = board.possible_drops(replies);
+    if(m_symmetry && board.is_symmetric()){//a mirrored reply is answered by the entry of its mirror
+        n_replies = drop_mirrored_moves(replies, n_replies);
+    }
+    std::stable_partition(replies.begin(), replies.begin() + n_replies, [expected](int col){return col == expected;});
 
-    return std::make_pair(std::distance(m_score.begin(), result), *result);
+    m_pondering = true;
+    m_ponder_stop = stop;
+    for(int i = 0; i < n_replies && !stop_requested(); ++i){
+        int col = replies[i];
+        Board child = board;
+        child.drop(col, opponent);
+        if(child.is_game_over(opponent)){
+            continue;
+        }
+        PonderEntry &entry = m_ponder[col];
+        entry.key = cache_key(child, entry.mirrored);
+        m_abort = false;    //a book move leaves it untouched
+        entry.result = get_move(child);
+        entry.stats = m_stats;
+        entry.stats.pondered = true;
+        entry.valid = !m_abort;
+    }
+    m_pondering = false;
+    m_ponder_stop = StopToken();
 }
 
 /**
- * @brief Ai::startFirstMove    : used as starting point for the threads
- * @param col                   : position to drop
+ * @brief BasicAi::probe_ponder : looks up board in the replies of the last ponder
  * @param board                 : current board
- * @param depth_to_go           : depth of minimax
+ * @param result                : pondered move and score if found
+ * @return                      : true if the reply was searched to the end
  */
-void Ai::startFirstMove(int col, Board board, int depth_to_go){
-    Board m_tmp_board = Board(board.get_positions());
-    m_tmp_board.drop(col, m_player);
+template<int W, int H>
+bool BasicAi<W, H>::probe_ponder(const Board &board, std::pair<int, int> &result){
+    bool mirrored;
+    typename Board::bitboard key = cache_key(board, mirrored);
+    for(const auto &entry : m_ponder){
+        if(entry.valid && entry.key == key){
+            m_depth_reached = entry.stats.depth;
+            m_stats = entry.stats;
+            result = entry.result;
+            result.first = mirror_move(result.first, mirrored != entry.mirrored);
+            return true;
+        }
+    }
+    return false;
+}
 
-    int s = min_value(m_tmp_board, depth_to_go - 1, -10000, 10000);
+/**
+ * @brief BasicAi::solve : solves board exactly for this player to move, the game must not be over
+ * @param board          : current board
+ * @return               : proven outcome, distance to the end, best move and search statistics
+ */
+template<int W, int H>
+Solver::Result BasicAi<W, H>::solve(const Board &board){
+    if constexpr(std::is_same<Board, ::Board>::value){
+        if(!m_solver){
+            m_solver.reset(new Solver());
+        }
+        return m_solver->solve(board, m_player);
+    }
+    else{//the solver and its tables are made for the standard board
+        Solver::Result result = Solver::Result();
+        result.move = -1;
+        return result;
+    }
+}
 
-    if(s > m_score[col]){
-        std::lock_guard<std::mutex> guard(mu);
-        m_score[col] = s;
+/**
+ * @brief BasicAi::load_book : maps an opening book generated by connect4_book, get_move answers book positions without search
+ * @param path               : book file
+ * @return                   : true if the book could be opened
+ */
+template<int W, int H>
+bool BasicAi<W, H>::load_book(const std::string &path){
+    if constexpr(std::is_same<Board, ::Board>::value){
+        return m_book.open(path);
+    }
+    else{//books hold positions of the standard board
+        (void)path;
+        return false;
     }
 }
 
 /**
- * @brief Ai::max_value : max function of minimax algorithm, returns max value, starts drops.size threads
- * @param board         : current board (might be temporary from min function)
- * @param depth_to_go   : current depth, shrinks per iteration
- * @param alpha         : alpha value for alpha-beta-pruning
- * @param beta          : beta value for alpha-beta-pruning
- * @return              : max value from eval for this depth
+ * @brief BasicAi::probe_book : looks up board in the opening book, a book of another evaluation is not used
+ * @param board               : current board
+ * @param depth               : entries searched to another depth are ignored, so the ai plays the moves of its own depth.
+ *                              0 takes any depth
+ * @param result              : book move and score if found
+ * @return                    : true if the book has the position
  */
-int Ai::max_value(Board board, int depth_to_go, int alpha, int beta){
-    if(depth_to_go == 0 || board.is_game_over(3 - m_player)){
-        return board.eval(m_player, m_winScore, m_looseScore, depth_to_go);
+template<int W, int H>
+bool BasicAi<W, H>::probe_book(const Board &board, int depth, std::pair<int, int> &result){
+    int book_depth = depth;
+    int move, score;
+    if constexpr(std::is_same<Board, ::Board>::value){
+        if(m_book.get_evaluation() != int(m_evaluation) || !m_book.lookup(board, m_player, move, score, book_depth)
+                || (depth > 0 && book_depth != depth)){
+            return false;
+        }
     }
     else{
-        if(depth_to_go == m_depth){//only in first iteration i.e. the very next move
-            std::vector<int> drops = board.possible_drops();
-            m_score.fill(-10000);
+        return false;
+    }
+    m_depth_reached = book_depth;
+    m_stats = SearchStats();
+    m_stats.depth = book_depth;
+    m_stats.book = true;
+    result = std::make_pair(move, score);
+    return true;
+}
 
-            std::vector<std::thread> t(drops.size());
+/**
+ * @brief BasicAi::get_depth_reached : depth of the deepest finished iteration of the last get_move
+ * @return
+ */
+template<int W, int H>
+int BasicAi<W, H>::get_depth_reached() const{
+    return m_depth_reached;
+}
 
-            for (int i = 0; i < drops.size(); ++i) {//make one thread per possible drop
-                int col = drops[i];
-                t[i] = std::thread(&Ai::startFirstMove, this, col, board, depth_to_go);
-            }
+/**
+ * @brief BasicAi::get_nodes : number of nodes searched by the last get_move
+ * @return
+ */
+template<int W, int H>
+uint64_t BasicAi<W, H>::get_nodes() const{
+    return m_stats.nodes;
+}
+
+/**
+ * @brief BasicAi::get_search_stats : statistics of the last get_move, the time is only measured by search
+ * @return
+ */
+template<int W, int H>
+const SearchStats &BasicAi<W, H>::get_search_stats() const{
+    return m_stats;
+}
+
+/**
+ * @brief BasicAi::set_move_ordering : switches move ordering on or off, off searches columns left to right
+ * @param enabled                    : true to order moves (default)
+ */
+template<int W, int H>
+void BasicAi<W, H>::set_move_ordering(bool enabled){
+    m_ordering = enabled;
+}
 
-            for (auto &thread: t) {
-                if(thread.joinable()){
-                    thread.join();}
+/**
+ * @brief BasicAi::set_symmetry : switches the symmetry reduction on or off, on a position and its mirror share
+ *                                their cached results and a symmetric root searches one move of each mirrored pair
+ * @param enabled               : true to use the symmetry (default)
+ */
+template<int W, int H>
+void BasicAi<W, H>::set_symmetry(bool enabled){
+    m_symmetry = enabled;
+}
+
+/**
+ * @brief BasicAi::set_evaluation : selects the evaluation of the leaves, a change empties the transposition table
+ *                                  and the pondered replies since their scores are of the other evaluation.
+ *                                  Must not be called during a search
+ * @param evaluation              : POSITIONAL (default) or THREATS, stronger per depth but slower per node
+ */
+template<int W, int H>
+void BasicAi<W, H>::set_evaluation(Evaluation evaluation){
+    if(evaluation == m_evaluation){
+        return;
+    }
+    m_evaluation = evaluation;
+    clear_cache();
+}
+
+/**
+ * @brief BasicAi::new_game : forgets the last game, so the next searches give the results of a new ai.
+ *                            Must not be called during a search
+ * @param player            : player this ai plays in the new game
+ */
+template<int W, int H>
+void BasicAi<W, H>::new_game(int player){
+    m_player = player;
+    m_move = -1;
+    m_depth_reached = 0;
+    m_stats = SearchStats();
+    clear_cache();
+}
+
+/**
+ * @brief BasicAi::clear_cache : empties the transposition table and the pondered replies
+ */
+template<int W, int H>
+void BasicAi<W, H>::clear_cache(){
+    m_tt.clear();
+    for(auto &entry : m_ponder){
+        entry.valid = false;
+    }
+}
+
+/**
+ * @brief BasicAi::set_threads : sets the number of search threads, the calling thread plus helpers
+ * @param threads              : number of threads, 0 for all available cores
+ */
+template<int W, int H>
+void BasicAi<W, H>::set_threads(int threads){
+    if(threads <= 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_threads = threads;
+}
+
+/**
+ * @brief BasicAi::set_progress_callback : sets the receiver of intermediate results, called on the main search thread
+ *                                         whenever the best root move improves or an iteration finishes, but at most once
+ *                                         per interval and not before the search ran for one interval. Not called while pondering
+ * @param callback                       : receiver of the progress, must return quickly, nullptr to switch it off
+ * @param interval_ms                    : minimum time between two calls
+ */
+template<int W, int H>
+void BasicAi<W, H>::set_progress_callback(std::function<void(const SearchProgress &)> callback, unsigned interval_ms){
+    m_progress = std::move(callback);
+    m_progress_interval = std::chrono::milliseconds(interval_ms);
+}
+
+/**
+ * @brief BasicAi::set_stop_token : cancels the running and all following searches of this ai once stop is requested,
+ *                                  they return the move of the deepest finished iteration (or the first possible move)
+ *                                  within STOP_CHECK_NODES nodes of the main thread
+ * @param stop                    : token of the owner of this ai
+ */
+template<int W, int H>
+void BasicAi<W, H>::set_stop_token(StopToken stop){
+    m_stop = std::move(stop);
+}
+
+/**
+ * @brief BasicAi::get_threads : number of search threads
+ * @return
+ */
+template<int W, int H>
+int BasicAi<W, H>::get_threads() const{
+    return m_threads;
+}
+
+/**
+ * @brief BasicAi::iterative_deepening : searches depth 1, 2, .. max_depth, keeps the result of the deepest finished iteration
+ *                                       helpers on the thread pool search the same position meanwhile (lazy smp), they share their
+ *                                       results through the transposition table and are stopped once the main search is done
+ * @param board                        : current board
+ * @param max_depth                    : depth of the last iteration
+ * @return
+ */
+template<int W, int H>
+std::pair<int, int> BasicAi<W, H>::iterative_deepening(const Board &board, int max_depth){
+    m_abort = false;
+    m_stop_helpers = false;
+    m_depth_reached = 0;
+    m_search_start = std::chrono::steady_clock::now();
+    m_next_progress = m_search_start + m_progress_interval;
+    m_contexts.resize(m_threads);
+    for(int i = 0; i < m_threads; ++i){
+        m_contexts[i].clear();
+        m_contexts[i].id = i;
+    }
+
+    //helpers run on the thread pool, tasks which only start after the search is over do nothing
+    auto group = std::make_shared<HelperGroup>();
+    for(int i = 1; i < m_threads; ++i){
+        ThreadPool::instance().submit([this, group, board, i, max_depth]{
+            {
+                std::lock_guard<std::mutex> guard(group->mutex);
+                if(group->closed){
+                    return;
+                }
+                ++group->active;
             }
+            helper_search(board, i, max_depth);
+            std::lock_guard<std::mutex> guard(group->mutex);
+            --group->active;
+            group->done.notify_all();
+        });
+    }
+
+    std::vector<int> drops = board.possible_drops();
+    std::pair<int, int> best = std::make_pair(drops.empty()? -1 : drops[0], 0);
+    Board search_board = board;
 
-            return 5;
+    for(int depth = 1; depth <= max_depth; ++depth){
+        if(stop_requested()){
+            m_abort = true;
+            break;
+        }
+        std::pair<int, int> result = search_root(search_board, m_contexts[0], depth);
+        if(m_abort){//unfinished iteration, keep the result of the last one
+            break;
+        }
+        best = result;
+        m_depth_reached = depth;
+        publish_progress(board, best.first, best.second, depth, true);
+        if(best.second > m_winScore - 100 || best.second <= m_looseScore){//result is proven
+            break;
         }
+    }
 
-        else{//all other moves
-            std::vector<int> drops = board.possible_drops();
-            int score = -10000;
+    m_stop_helpers = true;
+    {
+        std::unique_lock<std::mutex> lock(group->mutex);
+        group->closed = true;
+        group->done.wait(lock, [&group]{return group->active == 0;});
+    }
 
-            for(auto& col: drops){
-                Board m_tmp_board = Board(board.get_positions());
-                m_tmp_board.drop(col, m_player);
-                int s = min_value(m_tmp_board, depth_to_go - 1, alpha, beta);
-                if(s > score){
-                    score = s;
-                }
-                if(alpha < s){
-                    alpha = s;
-                }
-                if(beta <= alpha){
-                    break;
-                }
+    m_stats = SearchStats();
+    m_stats.depth = m_depth_reached;
+    for(const auto &ctx : m_contexts){
+        m_stats.nodes += ctx.nodes;
+        m_stats.thread_nodes.push_back(ctx.nodes);
+        SEARCH_STAT(
+            m_stats.leaf_evals += ctx.counters.leaf_evals;
+            m_stats.beta_cutoffs += ctx.counters.beta_cutoffs;
+            m_stats.first_move_cutoffs += ctx.counters.first_move_cutoffs;
+            m_stats.tt_cutoffs += ctx.counters.tt_cutoffs;
+            m_stats.tt_hits += ctx.counters.tt_hits;
+            m_stats.tt_misses += ctx.counters.tt_misses;
+            m_stats.tt_stores += ctx.counters.tt_stores;
+            m_stats.tt_overwrites += ctx.counters.tt_overwrites;
+            m_stats.max_ply = std::max(m_stats.max_ply, ctx.counters.max_ply);
+        )
+    }
+    return best;
+}
+
+/**
+ * @brief BasicAi::helper_search : iterative deepening of a helper thread, odd helpers run one iteration ahead
+ * @param board                  : root position, the copy this thread searches on
+ * @param id                     : index of the helper, > 0
+ * @param max_depth              : depth of the last iteration
+ */
+template<int W, int H>
+void BasicAi<W, H>::helper_search(Board board, int id, int max_depth){
+    SearchContext &ctx = m_contexts[id];
+    for(int depth = 1 + (id & 1); depth <= max_depth && !is_stopped(ctx); ++depth){
+        search_root(board, ctx, depth);
+    }
+}
+
+/**
+ * @brief BasicAi::publish_progress : passes an intermediate result to the progress callback if the interval is over
+ * @param board                     : root position
+ * @param move                      : best move so far
+ * @param score                     : its score
+ * @param depth                     : depth of the iteration
+ * @param complete                  : true if the iteration is finished
+ */
+template<int W, int H>
+void BasicAi<W, H>::publish_progress(const Board &board, int move, int score, int depth, bool complete){
+    if(!m_progress || m_pondering){
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if(now < m_next_progress){
+        return;
+    }
+    m_next_progress = now + m_progress_interval;
+
+    SearchProgress progress;
+    progress.move = move;
+    progress.score = score;
+    progress.depth = depth;
+    progress.complete = complete;
+    progress.pv = principal_variation(board, move, depth);
+    progress.nodes = m_contexts[0].nodes;
+    progress.time_us = std::chrono::duration_cast<std::chrono::microseconds>(now - m_search_start).count();
+    m_progress(progress);
+}
+
+/**
+ * @brief BasicAi::principal_variation : follows the best moves of the transposition table from the root
+ * @param board                        : root position
+ * @param move                         : first move
+ * @param depth                        : maximum length
+ * @return                             : columns of the variation, it ends at a table miss or the end of the game
+ */
+template<int W, int H>
+std::vector<int> BasicAi<W, H>::principal_variation(const Board &board, int move, int depth){
+    std::vector<int> pv;
+    Board pv_board = board;
+    int player = m_player;
+    while(move >= 0 && move < Board::WIDTH && pv_board.get_height(move) < Board::HEIGHT && int(pv.size()) < depth){
+        pv.push_back(move);
+        pv_board.drop(move, player);
+        if(pv_board.is_game_over(player)){
+            break;
+        }
+        player = 3 - player;
+        move = tt_best_move(pv_board);
+    }
+    return pv;
+}
+
+/**
+ * @brief BasicAi::search_root : searches all moves of the root position to depth
+ *                               every move is searched with a window one below the best score, so ties are exact
+ *                               and resolved to the leftmost column independent of the move order
+ * @param board                : board of this search thread
+ * @param ctx                  : move ordering tables of this search thread
+ * @param depth                : depth of this iteration
+ * @return                     : best move and its score, invalid if the search was stopped
+ */
+template<int W, int H>
+std::pair<int, int> BasicAi<W, H>::search_root(Board &board, SearchContext &ctx, int depth){
+    int alpha = -10000;
+    int beta = 10000;
+    int score;
+    int tt_move = -1;
+    probe_tt(board, ctx, depth, alpha, beta, score, tt_move);
+    alpha = -10000;
+    beta = 10000;
+
+    typename Board::movelist drops;
+    int n_drops = order_moves(board, ctx, 0, m_player, tt_move, drops);
+    if(m_symmetry && board.is_symmetric()){//mirrored moves have equal scores, the left one wins the tie anyway
+        n_drops = drop_mirrored_moves(drops, n_drops);
+    }
+    if(ctx.id > 0 && n_drops > 1){//helpers start with different moves to spread over the tree
+        std::rotate(drops.begin(), drops.begin() + (ctx.id % n_drops), drops.begin() + n_drops);
+    }
+
+    int best_score = -10001;
+    int best_col = -1;
+    for(int i = 0; i < n_drops; ++i){
+        if(ctx.id == 0 && stop_requested()){//a cancelled search doesn't start another root move
+            m_abort = true;
+        }
+        if(is_stopped(ctx)){
+            return std::make_pair(best_col, best_score);
+        }
+        int col = drops[i];
+        board.drop(col, m_player);
+        int s = min_value(board, ctx, 1, depth - 1, alpha - 1, beta);
+        board.undo(col);
+        if(is_stopped(ctx)){
+            return std::make_pair(best_col, best_score);
+        }
+        if(s > best_score || (s == best_score && col < best_col)){
+            best_score = s;
+            best_col = col;
+            if(ctx.id == 0){
+                publish_progress(board, best_col, best_score, depth, false);
             }
+        }
+        if(s > alpha){
+            alpha = s;
+        }
+    }
+    store_tt(board, ctx, depth, -10000, 10000, best_score, best_col);
+    return std::make_pair(best_col, best_score);
+}
+
+/**
+ * @brief BasicAi::count_node : counts a node, every STOP_CHECK_NODES nodes the main thread checks the deadline of a timed search
+ *                              and the stop tokens, the helpers follow the main thread through m_abort
+ * @param ctx                 : context of the search thread
+ * @return                    : true if the search has to be stopped
+ */
+template<int W, int H>
+bool BasicAi<W, H>::count_node(SearchContext &ctx){
+    ++ctx.nodes;
+    if(ctx.id == 0 && (ctx.nodes & (STOP_CHECK_NODES - 1)) == 0){
+        if((m_timed && m_depth_reached > 0 && std::chrono::steady_clock::now() >= m_deadline) || stop_requested()){
+            m_abort = true;
+        }
+    }
+    return is_stopped(ctx);
+}
+
+/**
+ * @brief BasicAi::evaluate : evaluates a leaf for this ai with the selected evaluation
+ * @param board             : board of the leaf
+ * @param to_move           : player to move on board
+ * @param depth_to_go       : remaining depth, added to win scores
+ * @return
+ */
+template<int W, int H>
+int BasicAi<W, H>::evaluate(const Board &board, int to_move, int depth_to_go) const{
+    if(m_evaluation == THREATS){
+        return board.eval_threats(m_player, to_move, m_winScore, m_looseScore, depth_to_go);
+    }
+    return board.eval(m_player, m_winScore, m_looseScore, depth_to_go);
+}
+
+/**
+ * @brief BasicAi::stop_requested : true if the search was cancelled or pondering has to stop
+ * @return
+ */
+template<int W, int H>
+bool BasicAi<W, H>::stop_requested() const{
+    return m_stop.stop_requested() || m_ponder_stop.stop_requested();
+}
+
+/**
+ * @brief BasicAi::is_stopped : true if the search of this thread has to be stopped
+ * @param ctx                 : context of the search thread
+ * @return
+ */
+template<int W, int H>
+bool BasicAi<W, H>::is_stopped(const SearchContext &ctx) const{
+    return m_abort.load(std::memory_order_relaxed) || (ctx.id > 0 && m_stop_helpers.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief BasicAi::get_tt_entries : number of positions in the transposition table, scans the table
+ * @return
+ */
+template<int W, int H>
+std::size_t BasicAi<W, H>::get_tt_entries() const{
+    return m_tt.count_entries();
+}
+
+/**
+ * @brief BasicAi::cache_key   : key of board in the transposition table and the pondered replies,
+ *                               the canonical key with the symmetry reduction, the key of board without
+ * @param board                : current board
+ * @param mirrored             : set to true if the key is the one of the mirrored position, moves are stored mirrored then
+ * @return
+ */
+template<int W, int H>
+typename BasicAi<W, H>::Board::bitboard BasicAi<W, H>::cache_key(const Board &board, bool &mirrored) const{
+    mirrored = m_symmetry && board.is_mirrored();
+    return mirrored? board.mirrored_key() : board.key();
+}
+
+/**
+ * @brief BasicAi::mirror_move : column of move on the mirrored board
+ * @param move                 : column or -1
+ * @param mirrored             : false to return move unchanged
+ * @return
+ */
+template<int W, int H>
+int BasicAi<W, H>::mirror_move(int move, bool mirrored){
+    return (mirrored && move >= 0)? Board::WIDTH - 1 - move : move;
+}
+
+/**
+ * @brief BasicAi::drop_mirrored_moves : removes the right column of each mirrored pair from the drops of a symmetric position
+ * @param drops                        : possible drops, their order is kept
+ * @param n_drops                      : number of drops
+ * @return                             : number of remaining drops
+ */
+template<int W, int H>
+int BasicAi<W, H>::drop_mirrored_moves(typename Board::movelist &drops, int n_drops){
+    int n_kept = 0;
+    for(int i = 0; i < n_drops; ++i){
+        if(drops[i] <= Board::WIDTH - 1 - drops[i]){
+            drops[n_kept++] = drops[i];
+        }
+    }
+    return n_kept;
+}
+
+/**
+ * @brief BasicAi::tt_best_move : best move of board stored in the transposition table
+ * @param board                 : current board
+ * @return                      : column, -1 on a miss
+ */
+template<int W, int H>
+int BasicAi<W, H>::tt_best_move(const Board &board){
+    TranspositionTable::Entry entry;
+    bool mirrored;
+    if(!m_tt.probe(Board::hash(cache_key(board, mirrored)), entry)){
+        return -1;
+    }
+    return mirror_move(entry.move, mirrored);
+}
+
+/**
+ * @brief BasicAi::probe_tt : looks up board in the transposition table and narrows the window with a hit
+ * @param board             : current board
+ * @param ctx               : context of the search thread, counts the probe
+ * @param depth_to_go       : current depth, entries of shallower searches are ignored
+ * @param alpha             : alpha value, raised by a lower bound
+ * @param beta              : beta value, lowered by an upper bound
+ * @param score             : stored score if the entry decides the node
+ * @param tt_move           : best move of the entry, also set if the entry is too shallow
+ * @return                  : true if the node needs no search
+ */
+template<int W, int H>
+bool BasicAi<W, H>::probe_tt(const Board &board, SearchContext &ctx, int depth_to_go, int &alpha, int &beta, int &score, int &tt_move){
+    TranspositionTable::Entry entry;
+    bool mirrored;
+    (void)ctx;  //only used by the counters
+    if(!m_tt.probe(Board::hash(cache_key(board, mirrored)), entry)){
+        SEARCH_STAT(++ctx.counters.tt_misses;)
+        return false;
+    }
+    SEARCH_STAT(++ctx.counters.tt_hits;)
+    tt_move = mirror_move(entry.move, mirrored);
+    if(entry.depth < depth_to_go){//only good enough to order the moves
+        return false;
+    }
+    //win scores are stored relative to the node, see store_tt
+    score = (entry.score > m_winScore - 100)? entry.score + depth_to_go : entry.score;
+    if(entry.bound == TranspositionTable::EXACT){
+        return true;
+    }
+    if(entry.bound == TranspositionTable::LOWER && score > alpha){
+        alpha = score;
+    }
+    else if(entry.bound == TranspositionTable::UPPER && score < beta){
+        beta = score;
+    }
+    return alpha >= beta;
+}
+
+/**
+ * @brief BasicAi::store_tt : stores a search result of board in the transposition table
+ * @param board             : current board
+ * @param ctx               : context of the search thread, counts the store
+ * @param depth_to_go       : depth the node was searched with
+ * @param alpha             : alpha value the node was searched with
+ * @param beta              : beta value the node was searched with
+ * @param score             : result of the search
+ * @param move              : best move of the node
+ */
+template<int W, int H>
+void BasicAi<W, H>::store_tt(const Board &board, SearchContext &ctx, int depth_to_go, int alpha, int beta, int score, int move){
+    TranspositionTable::Bound bound = TranspositionTable::EXACT;
+    if(score <= alpha){
+        bound = TranspositionTable::UPPER;
+    }
+    else if(score >= beta){
+        bound = TranspositionTable::LOWER;
+    }
+    //win scores contain the remaining depth of the leaf, store them without the depth of this node
+    int tt_score = (score > m_winScore - 100)? score - depth_to_go : score;
+    bool mirrored;
+    uint64_t key = Board::hash(cache_key(board, mirrored));
+    bool overwrite = m_tt.store(key, tt_score, depth_to_go, bound, mirror_move(move, mirrored));
+    SEARCH_STAT(++ctx.counters.tt_stores; ctx.counters.tt_overwrites += overwrite;)
+    (void)ctx;  //only used by the counters
+    (void)overwrite;
+}
+
+/**
+ * @brief BasicAi::SearchContext::clear : forgets all killer moves and history scores, resets the node count
+ */
+template<int W, int H>
+void BasicAi<W, H>::SearchContext::clear(){
+    nodes = 0;
+    counters = SearchCounters();
+    for(auto &ply : killers){
+        ply.fill(-1);
+    }
+    for(auto &side : history){
+        for(auto &col : side){
+            col.fill(0);
+        }
+    }
+}
+
+/**
+ * @brief BasicAi::order_moves : writes the possible drops in the order they should be searched to drops
+ *                               best move of the transposition table, killer moves of this ply, history score, center first
+ * @param board                : current board
+ * @param ctx                  : killer and history tables of this search thread
+ * @param ply                  : distance to the root
+ * @param player               : player to move
+ * @param tt_move              : best move stored in the transposition table, -1 if none
+ * @param drops                : filled with the ordered drops
+ * @return                     : number of possible drops
+ */
+template<int W, int H>
+int BasicAi<W, H>::order_moves(const Board &board, const SearchContext &ctx, int ply, int player, int tt_move, typename Board::movelist &drops){
+    int n_drops = board.possible_drops(drops);
+    if(!m_ordering){
+        return n_drops;
+    }
+
+    std::array<int, Board::WIDTH> keys;
+    for(int i = 0; i < n_drops; ++i){
+        int col = drops[i];
+        if(col == tt_move){
+            keys[i] = 1 << 30;
+        }
+        else if(col == ctx.killers[ply][0]){
+            keys[i] = 1 << 29;
+        }
+        else if(col == ctx.killers[ply][1]){
+            keys[i] = 1 << 28;
+        }
+        else{//history score, ties are broken center-out
+            keys[i] = ctx.history[player - 1][col][board.get_height(col)] * Board::WIDTH + CENTER_ORDER<W>[col];
+        }
+    }
+
+    //insertion sort, at most W moves
+    for(int i = 1; i < n_drops; ++i){
+        int col = drops[i];
+        int key = keys[i];
+        int j = i;
+        for(; j > 0 && keys[j - 1] < key; --j){
+            drops[j] = drops[j - 1];
+            keys[j] = keys[j - 1];
+        }
+        drops[j] = col;
+        keys[j] = key;
+    }
+    return n_drops;
+}
+
+/**
+ * @brief BasicAi::update_ordering : remembers a move which caused a beta cutoff as killer and in the history
+ * @param board                    : board before the move
+ * @param ctx                      : killer and history tables of this search thread
+ * @param ply                      : distance to the root
+ * @param player                   : player who played col
+ * @param col                      : move which caused the cutoff
+ * @param depth_to_go              : remaining depth, deeper cutoffs count more
+ */
+template<int W, int H>
+void BasicAi<W, H>::update_ordering(const Board &board, SearchContext &ctx, int ply, int player, int col, int depth_to_go){
+    if(ctx.killers[ply][0] != col){
+        ctx.killers[ply][1] = ctx.killers[ply][0];
+        ctx.killers[ply][0] = col;
+    }
+    int &h = ctx.history[player - 1][col][board.get_height(col)];
+    h = std::min(h + depth_to_go * depth_to_go, 1 << 20);
+}
+
+/**
+ * @brief BasicAi::max_value : max function of minimax algorithm, returns max value
+ * @param board              : board of this search thread, restored before returning
+ * @param ctx                : move ordering tables of this search thread
+ * @param ply                : distance to the root
+ * @param depth_to_go        : current depth, shrinks per iteration
+ * @param alpha              : alpha value for alpha-beta-pruning
+ * @param beta               : beta value for alpha-beta-pruning
+ * @return                   : max value from eval for this depth
+ */
+template<int W, int H>
+int BasicAi<W, H>::max_value(Board &board, SearchContext &ctx, int ply, int depth_to_go, int alpha, int beta){
+    if(count_node(ctx)){//result is discarded anyway
+        return 0;
+    }
+    SEARCH_STAT(ctx.counters.max_ply = std::max(ctx.counters.max_ply, ply);)
+    if(depth_to_go == 0 || board.is_game_over(3 - m_player)){
+        SEARCH_STAT(++ctx.counters.leaf_evals;)
+        return evaluate(board, m_player, depth_to_go);
+    }
+    else{
+        int score;
+        int tt_move = -1;
+        if(probe_tt(board, ctx, depth_to_go, alpha, beta, score, tt_move)){
+            SEARCH_STAT(++ctx.counters.tt_cutoffs;)
             return score;
         }
+        int alpha_start = alpha;
+        int best_col = -1;
+        typename Board::movelist drops;
+        int n_drops = order_moves(board, ctx, ply, m_player, tt_move, drops);
+        score = -10000;
+
+        for(int i = 0; i < n_drops; ++i){
+            int col = drops[i];
+            board.drop(col, m_player);
+            int s = min_value(board, ctx, ply + 1, depth_to_go - 1, alpha, beta);
+            board.undo(col);
+            if(is_stopped(ctx)){
+                return 0;
+            }
+            if(s > score){
+                score = s;
+                best_col = col;
+            }
+            if(alpha < s){
+                alpha = s;
+            }
+            if(beta <= alpha){
+                update_ordering(board, ctx, ply, m_player, col, depth_to_go);
+                SEARCH_STAT(++ctx.counters.beta_cutoffs; ctx.counters.first_move_cutoffs += (i == 0);)
+                break;
+            }
+        }
+        store_tt(board, ctx, depth_to_go, alpha_start, beta, score, best_col);
+        return score;
     }
 }
 
 /**
- * @brief Ai::min_value : min function of minimax algorithm, returns min value
- * @param board         : current board (might be temporary from max function)
- * @param depth_to_go   : current depth, shrinks per iteration
- * @param alpha         : alpha value for alpha-beta-pruning
- * @param beta          : beta value for alpha-beta-pruning
- * @return              : min value from eval for this depth
+ * @brief BasicAi::min_value : min function of minimax algorithm, returns min value
+ * @param board              : board of this search thread, restored before returning
+ * @param ctx                : move ordering tables of this search thread
+ * @param ply                : distance to the root
+ * @param depth_to_go        : current depth, shrinks per iteration
+ * @param alpha              : alpha value for alpha-beta-pruning
+ * @param beta               : beta value for alpha-beta-pruning
+ * @return                   : min value from eval for this depth
  */
-int Ai::min_value(Board board, int depth_to_go, int alpha, int beta){
+template<int W, int H>
+int BasicAi<W, H>::min_value(Board &board, SearchContext &ctx, int ply, int depth_to_go, int alpha, int beta){
+    if(count_node(ctx)){//result is discarded anyway
+        return 0;
+    }
+    SEARCH_STAT(ctx.counters.max_ply = std::max(ctx.counters.max_ply, ply);)
     if(depth_to_go == 0 || board.is_game_over(m_player)){
-        return board.eval(m_player, m_winScore, m_looseScore, depth_to_go);
+        SEARCH_STAT(++ctx.counters.leaf_evals;)
+        return evaluate(board, 3 - m_player, depth_to_go);
     }
     else{
-        std::vector<int> drops = board.possible_drops();
-        int score = 10000;
-        for(const auto& col: drops){
-            Board m_tmp_board = Board(board.get_positions());
-            m_tmp_board.drop(col, 3 - m_player);
-            int s = max_value(m_tmp_board, depth_to_go - 1, alpha, beta);
+        int score;
+        int tt_move = -1;
+        if(probe_tt(board, ctx, depth_to_go, alpha, beta, score, tt_move)){
+            SEARCH_STAT(++ctx.counters.tt_cutoffs;)
+            return score;
+        }
+        int beta_start = beta;
+        int best_col = -1;
+        typename Board::movelist drops;
+        int n_drops = order_moves(board, ctx, ply, 3 - m_player, tt_move, drops);
+        score = 10000;
+        for(int i = 0; i < n_drops; ++i){
+            int col = drops[i];
+            board.drop(col, 3 - m_player);
+            int s = max_value(board, ctx, ply + 1, depth_to_go - 1, alpha, beta);
+            board.undo(col);
+            if(is_stopped(ctx)){
+                return 0;
+            }
             if(s < score){
                 score = s;
-//                if(depth_to_go == _depth){_move = col;}
+                best_col = col;
             }
             if(beta > s){
                 beta = s;
             }
             if(alpha >= beta){
+                update_ordering(board, ctx, ply, 3 - m_player, col, depth_to_go);
+                SEARCH_STAT(++ctx.counters.beta_cutoffs; ctx.counters.first_move_cutoffs += (i == 0);)
                 break;
             }
         }
+        store_tt(board, ctx, depth_to_go, alpha, beta_start, score, best_col);
         return score;
     }
 }
+
+template class BasicAi<7, 6>;
+template class BasicAi<8, 7>;
+template class BasicAi<9, 7>;
@@ -4,26 +4,157 @@
 #include <thread>
 #include <future>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include "board.h"
+#include "transposition_table.h"
+#include "thread_pool.h"
+#include "book.h"
+#include "solver.h"
+#include "search_stats.h"
+#include "stop_token.h"
 
-class Ai
+/**
+ * @brief The BasicAi class searches moves for one player on a board of W columns and H rows
+ *
+ * The opening book and the solver only exist for the standard board, on other sizes get_move always searches
+ * and solve returns no move. Instantiated for 7x6 (Ai), 8x7 and 9x7 in ai.cpp.
+ */
+template<int W, int H>
+class BasicAi
 {
 public:
-    Ai(int depth, int player);
+    using Board = BasicBoard<W, H>;
+
+    //evaluation of the leaves: weighted stone positions only, or with open lines and threats of both players
+    enum Evaluation {POSITIONAL, THREATS};
+
+    struct SearchResult {
+        int move;
+        int score;
+        SearchStats stats;
+    };
+
+    BasicAi(int depth, int player, std::size_t tt_size_mb = 16);
     std::pair<int, int> get_move(const Board &board);
+    std::pair<int, int> get_move(const Board &board, unsigned time_ms);
+    SearchResult search(const Board &board, unsigned time_ms = 0);
+    void ponder(const Board &board, StopToken stop);
+    Solver::Result solve(const Board &board);
+    int get_depth_reached() const;
+    uint64_t get_nodes() const;
+    const SearchStats &get_search_stats() const;
+    void set_move_ordering(bool enabled);
+    void set_symmetry(bool enabled);
+    void set_evaluation(Evaluation evaluation);
+    void new_game(int player);
+    void set_threads(int threads);
+    void set_stop_token(StopToken stop);
+    void set_progress_callback(std::function<void(const SearchProgress &)> callback, unsigned interval_ms = 100);
+    int get_threads() const;
+    bool load_book(const std::string &path);
+    std::size_t get_tt_entries() const;
 
 private:
+    static constexpr int MAX_PLY = Board::WIDTH * Board::HEIGHT + 1;
+    //nodes of the main thread between two checks of the deadline and the stop tokens, a power of 2,
+    //about 0.1 ms with the threat evaluation
+    static constexpr uint64_t STOP_CHECK_NODES = 256;
+
+    //move ordering tables, node count and statistics, owned by one search thread, id 0 is the main thread
+    struct SearchContext {
+        std::array<std::array<int, 2>, MAX_PLY> killers;
+        std::array<std::array<std::array<int, Board::HEIGHT + 1>, Board::WIDTH>, 2> history;
+        uint64_t nodes;
+        SearchCounters counters;
+        int id;
+        void clear();
+    };
+
+    //result of pondering one reply of the opponent, get_move answers this position without search
+    struct PonderEntry {
+        typename Board::bitboard key = 0;  //cache_key of the reply
+        bool mirrored = false;             //key is the one of the mirrored reply
+        std::pair<int, int> result;
+        SearchStats stats;
+        bool valid = false;
+    };
+
+    //helper tasks of one search, shared with the pool tasks so a task starting after the search sees it is over
+    struct HelperGroup {
+        std::mutex mutex;
+        std::condition_variable done;
+        int active = 0;
+        bool closed = false;
+    };
+
     int m_depth;
     int m_player;
     int m_winScore;
     int m_looseScore;
     int m_move;
-    std::array<int, 7> m_score;
-    std::mutex mu;
+    TranspositionTable m_tt;
+    Book m_book;
+    std::unique_ptr<Solver> m_solver;   //created on the first solve, its table is large
 
-    void startFirstMove(int col, Board board, int depth_to_go);
-    int max_value(Board board, int depth_to_go, int alpha, int beta);
-    int min_value(Board board, int depth_to_go, int alpha, int beta);
+    //iterative deepening and time control
+    bool m_timed;
+    std::chrono::steady_clock::time_point m_deadline;
+    std::atomic<bool> m_abort;
+    std::atomic<bool> m_stop_helpers;
+    StopToken m_stop;       //cancels every search of this ai
+    int m_depth_reached;
+    SearchStats m_stats;    //of the last get_move
+
+    //pondering, one entry per column of the opponent's reply, the stop token is checked like the deadline
+    std::array<PonderEntry, Board::WIDTH> m_ponder;
+    bool m_pondering;
+    StopToken m_ponder_stop;
+
+    //intermediate results, published by the main search thread at most once per interval
+    std::function<void(const SearchProgress &)> m_progress;
+    std::chrono::milliseconds m_progress_interval;
+    std::chrono::steady_clock::time_point m_search_start;
+    std::chrono::steady_clock::time_point m_next_progress;
+
+    //move ordering, symmetry reduction and parallel search, one context per search thread
+    bool m_ordering;
+    bool m_symmetry;
+    Evaluation m_evaluation;
+    int m_threads;
+    std::vector<SearchContext> m_contexts;
+
+    void clear_cache();
+    bool probe_book(const Board &board, int depth, std::pair<int, int> &result);
+    bool probe_ponder(const Board &board, std::pair<int, int> &result);
+    std::pair<int, int> iterative_deepening(const Board &board, int max_depth);
+    void helper_search(Board board, int id, int max_depth);
+    void publish_progress(const Board &board, int move, int score, int depth, bool complete);
+    std::vector<int> principal_variation(const Board &board, int move, int depth);
+    std::pair<int, int> search_root(Board &board, SearchContext &ctx, int depth);
+    bool count_node(SearchContext &ctx);
+    bool stop_requested() const;
+    int evaluate(const Board &board, int to_move, int depth_to_go) const;
+    bool is_stopped(const SearchContext &ctx) const;
+    int max_value(Board &board, SearchContext &ctx, int ply, int depth_to_go, int alpha, int beta);
+    int min_value(Board &board, SearchContext &ctx, int ply, int depth_to_go, int alpha, int beta);
+
+    int order_moves(const Board &board, const SearchContext &ctx, int ply, int player, int tt_move, typename Board::movelist &drops);
+    void update_ordering(const Board &board, SearchContext &ctx, int ply, int player, int col, int depth_to_go);
+    typename Board::bitboard cache_key(const Board &board, bool &mirrored) const;
+    static int mirror_move(int move, bool mirrored);
+    static int drop_mirrored_moves(typename Board::movelist &drops, int n_drops);
+    int tt_best_move(const Board &board);
+    bool probe_tt(const Board &board, SearchContext &ctx, int depth_to_go, int &alpha, int &beta, int &score, int &tt_move);
+    void store_tt(const Board &board, SearchContext &ctx, int depth_to_go, int alpha, int beta, int score, int move);
 };
 
+//the ai of the game
+using Ai = BasicAi<7, 6>;
+
+extern template class BasicAi<7, 6>;
+extern template class BasicAi<8, 7>;
+extern template class BasicAi<9, 7>;
+
 #endif // AI_H
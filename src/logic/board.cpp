@@ -1,135 +1,459 @@
 #include "board.h"
-//type boardarray represents positions of board
-using boardarray = std::array<std::array<int, 6>, 7>;
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+template<int W, int H>
+using bits = typename BasicBoard<W, H>::bitboard;
+
+template<int W, int H>
+constexpr bits<W, H> cell_bit(int col, int row){
+    return bits<W, H>(1) << (col * (H + 1) + row);
+}
+
+//top cell of every column, a stone there means the column is full
+template<int W, int H>
+constexpr bits<W, H> make_top_mask(){
+    bits<W, H> mask = 0;
+    for(int col = 0; col < W; ++col){
+        mask |= cell_bit<W, H>(col, H - 1);
+    }
+    return mask;
+}
+
+//bit plane k holds all cells whose weight has bit k set, so the weighted sum is a few popcounts
+//the weight of a cell is the number of lines of 4 through it
+template<int W, int H>
+constexpr std::array<bits<W, H>, BasicBoard<W, H>::WEIGHT_PLANES> make_weight_planes(){
+    std::array<bits<W, H>, BasicBoard<W, H>::WEIGHT_PLANES> planes{};
+    for(int col = 0; col < W; ++col){
+        for(int row = 0; row < H; ++row){
+            for(int k = 0; k < BasicBoard<W, H>::WEIGHT_PLANES; ++k){
+                if(board_line_count(W, H, col, row) & (1 << k)){
+                    planes[k] |= cell_bit<W, H>(col, row);
+                }
+            }
+        }
+    }
+    return planes;
+}
+
+//weight of every bit of the bitboard, added to the score of a player by drop
+template<int W, int H>
+constexpr std::array<int, W * (H + 1)> make_bit_weights(){
+    std::array<int, W * (H + 1)> weights{};
+    for(int col = 0; col < W; ++col){
+        for(int row = 0; row < H; ++row){
+            weights[col * (H + 1) + row] = board_line_count(W, H, col, row);
+        }
+    }
+    return weights;
+}
+
+//all cells of the board, without the empty bit on top of the columns
+template<int W, int H>
+constexpr bits<W, H> make_board_mask(){
+    bits<W, H> mask = 0;
+    for(int col = 0; col < W; ++col){
+        mask |= ((bits<W, H>(1) << H) - 1) << (col * (H + 1));
+    }
+    return mask;
+}
+
+//bottom cell of every column
+template<int W, int H>
+constexpr bits<W, H> make_bottom_mask(){
+    bits<W, H> mask = 0;
+    for(int col = 0; col < W; ++col){
+        mask |= cell_bit<W, H>(col, 0);
+    }
+    return mask;
+}
+
+//cells of the rows 1, 3, 5, .. counted from the bottom, threats there are good for the starting player
+template<int W, int H>
+constexpr bits<W, H> make_odd_rows_mask(){
+    bits<W, H> mask = 0;
+    for(int col = 0; col < W; ++col){
+        for(int row = 0; row < H; row += 2){
+            mask |= cell_bit<W, H>(col, row);
+        }
+    }
+    return mask;
+}
+
+//lowest cell of every line of 4 cells in direction dir (a shift distance), the lines of the board are the bits of all 4 masks
+template<int W, int H>
+constexpr bits<W, H> make_line_starts(int dir){
+    bits<W, H> mask = 0;
+    for(int col = 0; col < W; ++col){
+        for(int row = 0; row < H; ++row){
+            int dcol = (dir == 1)? 0 : 1;
+            int drow = (dir == 1)? 1 : (dir == H + 1)? 0 : (dir == H + 2)? 1 : -1;
+            int end_col = col + 3 * dcol;
+            int end_row = row + 3 * drow;
+            if(end_col < W && end_row >= 0 && end_row < H){
+                mask |= cell_bit<W, H>(col, row);
+            }
+        }
+    }
+    return mask;
+}
 
 /**
- * @brief Board::Board Constructor used for the one "real" board. called by Game
+ * @brief The Geometry struct holds the masks and tables of a board size, all computed at compile time
  */
-Board::Board(){
+template<int W, int H>
+struct Geometry {
+    static constexpr int COL_BITS = H + 1;
+    //shift distances of the 4 line directions: vertical, diagonal down, horizontal, diagonal up
+    static constexpr int DIRECTIONS[4] = {1, COL_BITS - 1, COL_BITS, COL_BITS + 1};
+    static constexpr bits<W, H> TOP_MASK = make_top_mask<W, H>();
+    static constexpr bits<W, H> BOARD_MASK = make_board_mask<W, H>();
+    static constexpr bits<W, H> BOTTOM_MASK = make_bottom_mask<W, H>();
+    static constexpr bits<W, H> ODD_ROWS_MASK = make_odd_rows_mask<W, H>();
+    static constexpr bits<W, H> LINE_STARTS[4] = {make_line_starts<W, H>(DIRECTIONS[0]), make_line_starts<W, H>(DIRECTIONS[1]),
+                                                  make_line_starts<W, H>(DIRECTIONS[2]), make_line_starts<W, H>(DIRECTIONS[3])};
+    static constexpr std::array<bits<W, H>, BasicBoard<W, H>::WEIGHT_PLANES> WEIGHT_PLANE_MASKS = make_weight_planes<W, H>();
+    static constexpr std::array<int, W * COL_BITS> BIT_WEIGHTS = make_bit_weights<W, H>();
+};
+
+//the weights of the standard board, from the corner to the center
+static_assert(board_line_count(7, 6, 0, 0) == 3 && board_line_count(7, 6, 3, 2) == 13, "weights of the standard board");
+static_assert(Board::WEIGHT_PLANES == 4, "the batch evaluation has 4 weight planes");
+
+//weights of the threat evaluation
+constexpr int TWO_WEIGHT = 2;           //line with 2 own stones and 2 empty cells
+constexpr int THREE_WEIGHT = 6;         //line with 3 own stones and 1 empty cell
+constexpr int GOOD_THREAT_WEIGHT = 24;  //empty cell completing 4, in a row of the player's parity
+constexpr int THREAT_WEIGHT = 10;       //empty cell completing 4, other row
+constexpr int NEXT_MOVE_WIN = 2000;     //the player to move wins with the next move, not proven since the search didn't play it
+
+inline int popcount(uint64_t x){
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(x));
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+inline int popcount(unsigned __int128 x){
+    return popcount(uint64_t(x)) + popcount(uint64_t(x >> 64));
+}
+
+}
+
+/**
+ * @brief BasicBoard::BasicBoard Constructor used for the one "real" board. called by Game
+ */
+template<int W, int H>
+BasicBoard<W, H>::BasicBoard(){
     reset();
 }
 
 /**
- * @brief Board::Board Constructor used for temporary boards created by ai (no graphics)
+ * @brief BasicBoard::BasicBoard Constructor used for temporary boards created by ai (no graphics)
  * @param positions current state of game, copied to new board
  */
-Board::Board(boardarray positions):
-    m_positions(positions)
-{}
+template<int W, int H>
+BasicBoard<W, H>::BasicBoard(boardarray positions){
+    reset();
+    for(int col = 0; col < WIDTH; ++col){
+        for(int row = 0; row < HEIGHT; ++row){
+            int player = positions[col][HEIGHT - 1 - row];
+            if(player == 0){
+                break;
+            }
+            m_masks[player - 1] |= cell_bit<W, H>(col, row);
+            m_mirrors[player - 1] |= cell_bit<W, H>(WIDTH - 1 - col, row);
+            ++m_heights[col];
+            ++m_moves;
+        }
+    }
+    for(int i = 0; i < 2; ++i){
+        m_scores[i] = weighted_sum(m_masks[i]);
+        m_wins[i] = has_four(m_masks[i]);
+    }
+}
 
 /**
- * @brief Board::~Board   : empty destructor
+ * @brief BasicBoard::~BasicBoard   : empty destructor
  */
-Board::~Board()
+template<int W, int H>
+BasicBoard<W, H>::~BasicBoard()
 {}
 
 /**
- * @brief Board::drop   : Execute drop on boardarray positions
- * @param col           : defines move
- * @param player        : represents player who plays the move
+ * @brief BasicBoard::drop  : Execute drop on the bitboard of player and update its score and win flag, O(1)
+ * @param col               : defines move
+ * @param player            : represents player who plays the move
  */
-void Board::drop(int col, int player){
-        std::size_t row = std::distance(m_positions[col].begin(), std::find_if(m_positions[col].begin(), m_positions[col].end(), [](int val) { return val != 0; }))-1;
-        m_positions[col][row] = player;
+template<int W, int H>
+void BasicBoard<W, H>::drop(int col, int player){
+    int index = col * Geometry<W, H>::COL_BITS + m_heights[col];
+    bitboard &stones = m_masks[player - 1];
+    stones |= bitboard(1) << index;
+    m_mirrors[player - 1] |= bitboard(1) << ((WIDTH - 1 - col) * Geometry<W, H>::COL_BITS + m_heights[col]);
+    m_scores[player - 1] += Geometry<W, H>::BIT_WEIGHTS[index];
+    //a new four contains the new stone, the shifts over the whole bitboard are as cheap as looking around it
+    m_wins[player - 1] = m_wins[player - 1] || has_four(stones);
+    ++m_heights[col];
+    ++m_moves;
 }
 
 /**
- * @brief Board::is_game_over   : checks if player won or board full
- * @param player                : player for which the win criteria is checked
- * @return                      : true if game is over
+ * @brief BasicBoard::undo  : Takes back the last drop in col and its score, O(1)
+ * @param col               : column of the drop to take back
  */
-bool Board::is_game_over(int player){
-    return (possible_drops().size()==0 || is_winner(player));
+template<int W, int H>
+void BasicBoard<W, H>::undo(int col){
+    --m_heights[col];
+    int index = col * Geometry<W, H>::COL_BITS + m_heights[col];
+    bitboard bit = bitboard(1) << index;
+    int i = (m_masks[0] & bit)? 0 : 1;
+    m_masks[i] &= ~bit;
+    m_mirrors[i] &= ~(bitboard(1) << ((WIDTH - 1 - col) * Geometry<W, H>::COL_BITS + m_heights[col]));
+    m_scores[i] -= Geometry<W, H>::BIT_WEIGHTS[index];
+    if(m_wins[i]){//only undoing a winning stone is expensive, the search rarely does it
+        m_wins[i] = has_four(m_masks[i]);
+    }
+    --m_moves;
 }
 
 /**
- * @brief Board::is_full    : checks if game is over
+ * @brief BasicBoard::is_game_over  : checks if player won or board full
+ * @param player                    : player for which the win criteria is checked
+ * @return                          : true if game is over
+ */
+template<int W, int H>
+bool BasicBoard<W, H>::is_game_over(int player) const{
+    return (is_full() || is_winner(player));
+}
+
+/**
+ * @brief BasicBoard::is_full   : checks if game is over
  * @return
  */
-bool Board::is_full(){
-    return (possible_drops().size()==0)? true : false;
+template<int W, int H>
+bool BasicBoard<W, H>::is_full() const{
+    return m_moves == WIDTH * HEIGHT;
 }
 
 /**
- * @brief Board::is_winner  : checks if player won
- * @param player            : player for which the win criteria is checked
+ * @brief BasicBoard::get_moves : number of stones on the board
  * @return
  */
-bool Board::is_winner(int player){
-//    vertical
-    for(auto col : m_positions){
-        if(std::search_n(col.begin(), col.end(), 4, player) != col.end()){return true;};//could be faster with hints somehow
-    }
-//    horizontal
-    for(int j = 0; j < 6; ++j){
-        for(int i = 0; i < 4; ++i){
-            if(m_positions[i][j] == player && m_positions[i+1][j] == player && m_positions[i+2][j] == player && m_positions[i+3][j] == player){
-                return true;
-            }
+template<int W, int H>
+int BasicBoard<W, H>::get_moves() const{
+    return m_moves;
+}
+
+/**
+ * @brief BasicBoard::get_height    : number of stones in column col
+ * @param col                       : column
+ * @return
+ */
+template<int W, int H>
+int BasicBoard<W, H>::get_height(int col) const{
+    return m_heights[col];
+}
+
+/**
+ * @brief BasicBoard::has_four  : checks a single bitboard for 4 connected stones
+ * @param stones                : bitboard of one player
+ * @return
+ */
+template<int W, int H>
+bool BasicBoard<W, H>::has_four(bitboard stones){
+    for(int dir : Geometry<W, H>::DIRECTIONS){
+        bitboard pairs = stones & (stones >> dir);
+        if(pairs & (pairs >> (2 * dir))){
+            return true;
         }
     }
-//    diagonal down
-        for(int j = 0; j < 3; ++j){
-            for(int i = 0; i < 4; ++i){
-                if(m_positions[i][j] == player && m_positions[i+1][j+1] == player && m_positions[i+2][j+2] == player && m_positions[i+3][j+3] == player){
-                    return true;
-                }
-            }
-        }
-//    diagonal up
-        for(int j = 3; j < 6; ++j){
-            for(int i = 0; i < 4; ++i){
-                if(m_positions[i][j] == player && m_positions[i+1][j-1] == player && m_positions[i+2][j-2] == player && m_positions[i+3][j-3] == player){
-                    return true;
-                }
-            }
-        }
     return false;
 }
 
 /**
- * @brief Board::eval   : Evaluates positions of player, gives back nummeric value of how good the positions are
- * @param player        : Player for which the evaluation is carried out
- * @param win           : Value of a win situation
- * @param loose         : Value of a loose situation
- * @param depth         : Depth of current board evaluation
+ * @brief BasicBoard::is_winner : checks if player won
+ * @param player                : player for which the win criteria is checked
+ * @return
+ */
+template<int W, int H>
+bool BasicBoard<W, H>::is_winner(int player) const{
+    return m_wins[player - 1];
+}
+
+/**
+ * @brief BasicBoard::weighted_sum  : positional score of stones, summed up per weight bit plane
+ * @param stones                    : bitboard of one player
  * @return
  */
-int Board::eval(int player, int win, int loose, int depth){
-    if(is_winner(player)){//return +depth so faster wins are better
+template<int W, int H>
+int BasicBoard<W, H>::weighted_sum(bitboard stones){
+    int sum = 0;
+    for(int k = 0; k < WEIGHT_PLANES; ++k){
+        sum += popcount(stones & Geometry<W, H>::WEIGHT_PLANE_MASKS[k]) << k;
+    }
+    return sum;
+}
+
+/**
+ * @brief BasicBoard::weight_planes : bit planes of the positional weights, the weighted sum of stones is
+ *                                    the sum of popcount(stones & plane k) << k
+ * @return
+ */
+template<int W, int H>
+const std::array<typename BasicBoard<W, H>::bitboard, BasicBoard<W, H>::WEIGHT_PLANES> &BasicBoard<W, H>::weight_planes(){
+    return Geometry<W, H>::WEIGHT_PLANE_MASKS;
+}
+
+/**
+ * @brief BasicBoard::eval  : Evaluates positions of player, gives back nummeric value of how good the positions are
+ * @param player            : Player for which the evaluation is carried out
+ * @param win               : Value of a win situation
+ * @param loose             : Value of a loose situation
+ * @param depth             : Depth of current board evaluation
+ * @return
+ */
+template<int W, int H>
+int BasicBoard<W, H>::eval(int player, int win, int loose, int depth) const{
+    if(m_wins[player - 1]){//return +depth so faster wins are better
         return win+depth;
     }
-    else if(is_winner(3-player)){
+    else if(m_wins[2 - player]){
         return loose;
     }
-    else{//was unable to put the variable somewhere meaningful (i.e. init in i, allocate in constructors
-        const boardarray _weights = { 3, 4, 5, 5, 4, 3,
-                                      4, 6, 8, 8, 6, 4,
-                                      5, 8, 11, 11, 8, 5,
-                                      7, 10, 13, 13, 10, 7,
-                                      5, 8, 11, 11, 8, 5,
-                                      4, 6, 8, 8, 6, 4,
-                                      3, 4, 5, 5, 4, 3};
-        int sum = 0;
-        for(int col = 0; col<7; ++col){
-            for(int row = 0; row<6; ++row){
-                if(m_positions[col][row] == player){
-                    sum += _weights[col][row];
-                }
-            }
-        }
-        return sum;
+    else{//kept up to date by drop and undo
+        return m_scores[player - 1];
     }
 }
 
 /**
- * @brief Board::possible_drops : returns all possible positions to drop in a vector
+ * @brief BasicBoard::eval_reference    : eval recomputed from the bitboards, to check the incremental state against
+ * @param player                        : Player for which the evaluation is carried out
+ * @param win                           : Value of a win situation
+ * @param loose                         : Value of a loose situation
+ * @param depth                         : Depth of current board evaluation
  * @return
  */
-std::vector<int> Board::possible_drops(){
+template<int W, int H>
+int BasicBoard<W, H>::eval_reference(int player, int win, int loose, int depth) const{
+    if(has_four(m_masks[player - 1])){
+        return win+depth;
+    }
+    else if(has_four(m_masks[2 - player])){
+        return loose;
+    }
+    else{
+        return weighted_sum(m_masks[player - 1]);
+    }
+}
+
+/**
+ * @brief BasicBoard::winning_cells : empty cells which would complete 4 connected stones of player
+ * @param player                    : player 1 or 2
+ * @return                          : bitboard of the cells
+ */
+template<int W, int H>
+typename BasicBoard<W, H>::bitboard BasicBoard<W, H>::winning_cells(int player) const{
+    bitboard stones = m_masks[player - 1];
+    bitboard cells = (stones << 1) & (stones << 2) & (stones << 3);
+    for(int i = 1; i < 4; ++i){
+        int dir = Geometry<W, H>::DIRECTIONS[i];
+        bitboard pairs = (stones << dir) & (stones << (2 * dir));
+        cells |= pairs & (stones << (3 * dir));
+        cells |= pairs & (stones >> dir);
+        pairs = (stones >> dir) & (stones >> (2 * dir));
+        cells |= pairs & (stones << dir);
+        cells |= pairs & (stones >> (3 * dir));
+    }
+    return cells & Geometry<W, H>::BOARD_MASK & ~(m_masks[0] | m_masks[1]);
+}
+
+/**
+ * @brief BasicBoard::threat_score  : lines with 2 and 3 stones of player and its threats, evaluated on all lines at once
+ * @param player                    : player 1 or 2
+ * @param starter                   : player who made the first move, threats in odd rows are good for it, in even rows for the other
+ * @return
+ */
+template<int W, int H>
+int BasicBoard<W, H>::threat_score(int player, int starter) const{
+    using G = Geometry<W, H>;
+    bitboard own = m_masks[player - 1];
+    bitboard not_opponent = G::BOARD_MASK & ~m_masks[2 - player];
+    int twos = 0;
+    int threes = 0;
+    for(int i = 0; i < 4; ++i){
+        int dir = G::DIRECTIONS[i];
+        //lines without opponent stones, by their lowest cell
+        bitboard open = not_opponent & (not_opponent >> dir) & (not_opponent >> (2 * dir))
+                & (not_opponent >> (3 * dir)) & G::LINE_STARTS[i];
+        //number of own stones per line by two half adders
+        bitboard x0 = own;
+        bitboard x1 = own >> dir;
+        bitboard x2 = own >> (2 * dir);
+        bitboard x3 = own >> (3 * dir);
+        bitboard sum_low = x0 ^ x1;
+        bitboard carry_low = x0 & x1;
+        bitboard sum_high = x2 ^ x3;
+        bitboard carry_high = x2 & x3;
+        bitboard two = (carry_low & ~carry_high & ~sum_high) | (carry_high & ~carry_low & ~sum_low) | (sum_low & sum_high);
+        bitboard three = (carry_low & sum_high) | (carry_high & sum_low);
+        twos += popcount(two & open);
+        threes += popcount(three & open);
+    }
+    bitboard threats = winning_cells(player);
+    bitboard good_rows = (player == starter)? G::ODD_ROWS_MASK : G::BOARD_MASK & ~G::ODD_ROWS_MASK;
+    int good_threats = popcount(threats & good_rows);
+    return TWO_WEIGHT * twos + THREE_WEIGHT * threes
+            + GOOD_THREAT_WEIGHT * good_threats + THREAT_WEIGHT * (popcount(threats) - good_threats);
+}
+
+/**
+ * @brief BasicBoard::eval_threats  : Evaluation with threats: positional score, open lines and threats of player minus those of the opponent
+ * @param player                    : Player for which the evaluation is carried out
+ * @param to_move                   : Player to move on this board
+ * @param win                       : Value of a win situation
+ * @param loose                     : Value of a loose situation
+ * @param depth                     : Depth of current board evaluation
+ * @return
+ */
+template<int W, int H>
+int BasicBoard<W, H>::eval_threats(int player, int to_move, int win, int loose, int depth) const{
+    if(m_wins[player - 1]){
+        return win+depth;
+    }
+    else if(m_wins[2 - player]){
+        return loose;
+    }
+
+    //the player to move wins with a threat it can play, the other one with two of them
+    bitboard playable = ((m_masks[0] | m_masks[1]) + Geometry<W, H>::BOTTOM_MASK) & Geometry<W, H>::BOARD_MASK;
+    int to_move_threats = popcount(winning_cells(to_move) & playable);
+    int other_threats = popcount(winning_cells(3 - to_move) & playable);
+    if(to_move_threats > 0 || other_threats > 1){
+        bool player_wins = (to_move_threats > 0) == (to_move == player);
+        return player_wins? NEXT_MOVE_WIN : -NEXT_MOVE_WIN;
+    }
+
+    int starter = (m_moves % 2 == 0)? to_move : 3 - to_move;
+    return m_scores[player - 1] - m_scores[2 - player] + threat_score(player, starter) - threat_score(3 - player, starter);
+}
+
+/**
+ * @brief BasicBoard::possible_drops   : returns all possible positions to drop in a vector
+ * @return
+ */
+template<int W, int H>
+std::vector<int> BasicBoard<W, H>::possible_drops() const{
     std::vector<int> drops;
-    for(int i=0; i<7; ++i){
-        if(m_positions[i][0]==0){
+    bitboard full = (m_masks[0] | m_masks[1]) & Geometry<W, H>::TOP_MASK;
+    for(int i=0; i<WIDTH; ++i){
+        if(!(full & cell_bit<W, H>(i, HEIGHT - 1))){
             drops.push_back(i);
         }
     }
@@ -137,61 +461,195 @@ std::vector<int> Board::possible_drops(){
 }
 
 /**
- * @brief Board::reset  :
+ * @brief BasicBoard::possible_drops   : writes all possible positions to drop to drops, no allocation
+ * @param drops                        : buffer for the possible drops
+ * @return                             : number of possible drops
+ */
+template<int W, int H>
+int BasicBoard<W, H>::possible_drops(movelist &drops) const{
+    int n_drops = 0;
+    bitboard full = (m_masks[0] | m_masks[1]) & Geometry<W, H>::TOP_MASK;
+    for(int i=0; i<WIDTH; ++i){
+        if(!(full & cell_bit<W, H>(i, HEIGHT - 1))){
+            drops[n_drops++] = i;
+        }
+    }
+    return n_drops;
+}
+
+/**
+ * @brief BasicBoard::reset :
+ */
+template<int W, int H>
+void BasicBoard<W, H>::reset(){
+    m_masks.fill(0);
+    m_mirrors.fill(0);
+    m_heights.fill(0);
+    m_moves = 0;
+    m_scores.fill(0);
+    m_wins.fill(false);
+}
+
+/**
+ * @brief BasicBoard::get_positions : return current positions, converted from the bitboards
+ * @return
+ */
+template<int W, int H>
+typename BasicBoard<W, H>::boardarray BasicBoard<W, H>::get_positions() const{
+    boardarray positions;
+    for(int col = 0; col < WIDTH; ++col){
+        for(int row = 0; row < HEIGHT; ++row){
+            bitboard bit = cell_bit<W, H>(col, HEIGHT - 1 - row);
+            positions[col][row] = (m_masks[0] & bit)? 1 : (m_masks[1] & bit)? 2 : 0;
+        }
+    }
+    return positions;
+}
+
+/**
+ * @brief BasicBoard::key   : unique key of the position, stones of player 1 plus all stones
+ * @return
+ */
+template<int W, int H>
+typename BasicBoard<W, H>::bitboard BasicBoard<W, H>::key() const{
+    return m_masks[0] + (m_masks[0] | m_masks[1]);
+}
+
+/**
+ * @brief BasicBoard::mirrored_key  : key of the left-right mirrored position
+ * @return
+ */
+template<int W, int H>
+typename BasicBoard<W, H>::bitboard BasicBoard<W, H>::mirrored_key() const{
+    return m_mirrors[0] + (m_mirrors[0] | m_mirrors[1]);
+}
+
+/**
+ * @brief BasicBoard::canonical_key : the smaller one of key and mirrored_key, the same for a position and its mirror
+ * @return
+ */
+template<int W, int H>
+typename BasicBoard<W, H>::bitboard BasicBoard<W, H>::canonical_key() const{
+    return std::min(key(), mirrored_key());
+}
+
+/**
+ * @brief BasicBoard::is_mirrored   : true if the canonical key is the one of the mirrored position
+ * @return
+ */
+template<int W, int H>
+bool BasicBoard<W, H>::is_mirrored() const{
+    return mirrored_key() < key();
+}
+
+/**
+ * @brief BasicBoard::is_symmetric  : true if the position is its own mirror, its mirrored moves have equal results
+ * @return
+ */
+template<int W, int H>
+bool BasicBoard<W, H>::is_symmetric() const{
+    return m_masks == m_mirrors;
+}
+
+/**
+ * @brief BasicBoard::hash  : 64 bit key of the transposition table, key itself if the bitboard has 64 bits
+ * @return
+ */
+template<int W, int H>
+uint64_t BasicBoard<W, H>::hash() const{
+    return hash(key());
+}
+
+/**
+ * @brief BasicBoard::hash  : 64 bit hash of a key, the key itself if the bitboard has 64 bits
+ * @param key               : key or canonical key of a position
+ * @return
+ */
+template<int W, int H>
+uint64_t BasicBoard<W, H>::hash(bitboard key){
+    if constexpr(sizeof(bitboard) == sizeof(uint64_t)){
+        return key;
+    }
+    else{
+        return uint64_t(key) ^ (uint64_t(key >> 64) * 0x9E3779B97F4A7C15ull);
+    }
+}
+
+/**
+ * @brief BasicBoard::player_key    : unique key of the position seen by player, stones of player plus all stones
+ *                                    independent of the colors, used by data stored across games like the opening book
+ * @param player                    : player to move
+ * @return
  */
-void Board::reset(){
-    std::array<int, 6> dummy;
-    dummy.fill(0);
-    m_positions.fill(dummy);
+template<int W, int H>
+typename BasicBoard<W, H>::bitboard BasicBoard<W, H>::player_key(int player) const{
+    return m_masks[player - 1] + (m_masks[0] | m_masks[1]);
 }
 
 /**
- * @brief Board::get_positions  : return current positions
+ * @brief BasicBoard::mirrored_player_key   : player_key of the left-right mirrored position
+ * @param player                            : player to move
  * @return
  */
-boardarray Board::get_positions(){
-    return m_positions;
+template<int W, int H>
+typename BasicBoard<W, H>::bitboard BasicBoard<W, H>::mirrored_player_key(int player) const{
+    return m_mirrors[player - 1] + (m_mirrors[0] | m_mirrors[1]);
 }
 
 /**
- * @brief Board::get_winning_line   : return pair of start and endpoint of the 4 connected winner coins
- * @param player                    : winning player
+ * @brief BasicBoard::get_stones    : bitboard of the stones of player
+ * @param player                    : player 1 or 2
  * @return
  */
-std::pair<std::pair<int, int>, std::pair<int, int> > Board::get_winning_line(int player)
+template<int W, int H>
+typename BasicBoard<W, H>::bitboard BasicBoard<W, H>::get_stones(int player) const{
+    return m_masks[player - 1];
+}
+
+/**
+ * @brief BasicBoard::get_mask  : bitboard of all stones
+ * @return
+ */
+template<int W, int H>
+typename BasicBoard<W, H>::bitboard BasicBoard<W, H>::get_mask() const{
+    return m_masks[0] | m_masks[1];
+}
+
+/**
+ * @brief BasicBoard::get_winning_line  : return pair of start and endpoint of the 4 connected winner coins
+ *                                        in the coordinates of get_positions, row 0 on top
+ * @param player                        : winning player
+ * @return
+ */
+template<int W, int H>
+std::pair<std::pair<int, int>, std::pair<int, int> > BasicBoard<W, H>::get_winning_line(int player) const
 {
-    //returns pair <start, end> with start = <x,y> and end = <x,y>
-    //    vertical
-        for(int i = 0; i < 7; ++i){
-            for(int j = 0; j < 3; ++j){
-                if(m_positions[i][j] == player && m_positions[i][j+1] == player && m_positions[i][j+2] == player && m_positions[i][j+3] == player){
-                    return std::make_pair(std::make_pair(i, j), std::make_pair(i, j+3));
-                }
-            }
-        }
-    //    horizontal
-        for(int j = 0; j < 6; ++j){
-            for(int i = 0; i < 4; ++i){
-                if(m_positions[i][j] == player && m_positions[i+1][j] == player && m_positions[i+2][j] == player && m_positions[i+3][j] == player){
-                    return std::make_pair(std::make_pair(i, j), std::make_pair(i+3, j));
+    boardarray positions = get_positions();
+    //vertical, horizontal, diagonal down, diagonal up, as column and row steps
+    constexpr int dcols[4] = {0, 1, 1, 1};
+    constexpr int drows[4] = {1, 0, 1, -1};
+    for(int dir = 0; dir < 4; ++dir){
+        for(int i = 0; i < WIDTH; ++i){
+            for(int j = 0; j < HEIGHT; ++j){
+                int end_i = i + 3 * dcols[dir];
+                int end_j = j + 3 * drows[dir];
+                if(end_i >= WIDTH || end_j < 0 || end_j >= HEIGHT){
+                    continue;
                 }
-            }
-        }
-    //    diagonal down
-            for(int j = 0; j < 3; ++j){
-                for(int i = 0; i < 4; ++i){
-                    if(m_positions[i][j] == player && m_positions[i+1][j+1] == player && m_positions[i+2][j+2] == player && m_positions[i+3][j+3] == player){
-                        return std::make_pair(std::make_pair(i, j), std::make_pair(i+3, j+3));
-                    }
+                int k = 0;
+                while(k < 4 && positions[i + k * dcols[dir]][j + k * drows[dir]] == player){
+                    ++k;
                 }
-            }
-    //    diagonal up
-            for(int j = 3; j < 6; ++j){
-                for(int i = 0; i < 4; ++i){
-                    if(m_positions[i][j] == player && m_positions[i+1][j-1] == player && m_positions[i+2][j-2] == player && m_positions[i+3][j-3] == player){
-                        return std::make_pair(std::make_pair(i, j), std::make_pair(i+3, j-3));
-                    }
+                if(k == 4){
+                    return std::make_pair(std::make_pair(i, j), std::make_pair(end_i, end_j));
                 }
             }
+        }
+    }
+    //no line found
+    return std::make_pair(std::make_pair(-1, -1), std::make_pair(-1, -1));
 }
 
+template class BasicBoard<7, 6>;
+template class BasicBoard<8, 7>;
+template class BasicBoard<9, 7>;
@@ -1,47 +1,144 @@
 #ifndef BOARD_H
 #define BOARD_H
 
-#include <QGraphicsItem>
-#include <QGraphicsScene>
-#include <QWidget>
-#include <QScrollArea>
+#include <array>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 #include <iostream>
 #include <algorithm>
 
-#include "observer.h"
+/**
+ * @brief board_line_count  : number of lines of 4 cells through a cell, the positional weight of the cell
+ * @param width             : columns of the board
+ * @param height            : rows of the board
+ * @param col               : column of the cell
+ * @param row               : row of the cell, either from the top or the bottom, the count is symmetric
+ * @return
+ */
+constexpr int board_line_count(int width, int height, int col, int row){
+    const int dcols[4] = {0, 1, 1, 1};
+    const int drows[4] = {1, 0, 1, -1};
+    int count = 0;
+    for(int dir = 0; dir < 4; ++dir){
+        //lines starting 0..3 cells before the cell in the direction
+        for(int back = 0; back < 4; ++back){
+            int start_col = col - back * dcols[dir];
+            int start_row = row - back * drows[dir];
+            int end_col = start_col + 3 * dcols[dir];
+            int end_row = start_row + 3 * drows[dir];
+            if(start_col >= 0 && start_row >= 0 && start_row < height && end_col < width && end_row >= 0 && end_row < height){
+                ++count;
+            }
+        }
+    }
+    return count;
+}
 
 /**
- * @brief The Board class represents the board and provides evaluation functions on it
+ * @brief board_weight_planes   : number of bits of the largest positional weight of a board
+ * @param width                 : columns of the board
+ * @param height                : rows of the board
+ * @return
  */
-class Board
-{
-    using boardarray = std::array<std::array<int, 6>, 7>;
+constexpr int board_weight_planes(int width, int height){
+    int max_weight = 0;
+    for(int col = 0; col < width; ++col){
+        for(int row = 0; row < height; ++row){
+            max_weight = std::max(max_weight, board_line_count(width, height, col, row));
+        }
+    }
+    int planes = 0;
+    while(max_weight >> planes){
+        ++planes;
+    }
+    return planes;
+}
 
+/**
+ * @brief The BasicBoard class represents a board of W columns and H rows and provides evaluation functions on it
+ *
+ * The state is kept as bitboards: one mask per player, where column col occupies the bits
+ * col*(H+1) .. col*(H+1)+H-1 from bottom to top. The extra bit on top of every column is always
+ * empty, so shifted masks never bleed into the next column. Boards of up to 64 bits use uint64_t,
+ * larger ones unsigned __int128. The line masks and weights are generated at compile time per size.
+ * The positional score and the win flag of both players are updated by drop and undo, so eval is O(1),
+ * as are the mirrored masks, the keys of the mirrored position come without shifting columns around.
+ * Instantiated for 7x6 (Board), 8x7 and 9x7 in board.cpp.
+ */
+template<int W, int H>
+class BasicBoard
+{
 public:
+    static constexpr int WIDTH = W;
+    static constexpr int HEIGHT = H;
+    static constexpr int WEIGHT_PLANES = board_weight_planes(W, H);    //bit planes of the positional weights, see weight_planes
+
+    static_assert(W >= 4 && H >= 4, "a board needs room for 4 connected stones");
+    static_assert(W * (H + 1) <= 128, "the bitboard of a board has at most 128 bits");
 
-    Board();
-    Board(boardarray);
-    ~Board();
+    using bitboard = typename std::conditional<W * (H + 1) <= 64, uint64_t, unsigned __int128>::type;
+    using boardarray = std::array<std::array<int, H>, W>;
+
+    //fixed capacity buffer for the possible drops, used by the search instead of a vector
+    using movelist = std::array<int, W>;
+
+    BasicBoard();
+    BasicBoard(boardarray);
+    ~BasicBoard();
 
     void drop(int col, int player);
-    std::vector<int> possible_drops();
+    void undo(int col);
+    std::vector<int> possible_drops() const;
+    int possible_drops(movelist &drops) const;
     void reset();
 
-    bool is_game_over(int player);
-    bool is_winner(int player);
+    bool is_game_over(int player) const;
+    bool is_winner(int player) const;
 
-    bool is_full();
-    int eval(int player, int win, int loose, int depth);
+    bool is_full() const;
+    int get_moves() const;
+    int get_height(int col) const;
+    int eval(int player, int win, int loose, int depth) const;
+    int eval_reference(int player, int win, int loose, int depth) const;
+    int eval_threats(int player, int to_move, int win, int loose, int depth) const;
+    bitboard winning_cells(int player) const;
     void celebration(int player);
 
-    boardarray get_positions();
-    std::pair<std::pair<int, int>, std::pair<int, int>> get_winning_line(int player);
+    boardarray get_positions() const;
+    bitboard key() const;
+    bitboard mirrored_key() const;
+    bitboard canonical_key() const;
+    bool is_mirrored() const;
+    bool is_symmetric() const;
+    uint64_t hash() const;
+    static uint64_t hash(bitboard key);
+    bitboard player_key(int player) const;
+    bitboard mirrored_player_key(int player) const;
+    bitboard get_stones(int player) const;
+    bitboard get_mask() const;
 
-private:
-    boardarray m_positions;
+    static bool has_four(bitboard stones);
+    static int weighted_sum(bitboard stones);
+    static const std::array<bitboard, WEIGHT_PLANES> &weight_planes();
+    std::pair<std::pair<int, int>, std::pair<int, int>> get_winning_line(int player) const;
 
+private:
+    std::array<bitboard, 2> m_masks;    //stones of player 1 and player 2
+    std::array<bitboard, 2> m_mirrors;  //the same stones mirrored left-right
+    std::array<int, W> m_heights;       //number of stones per column
+    int m_moves;                        //number of stones on the board
+    std::array<int, 2> m_scores;        //positional score of the stones of player 1 and player 2
+    std::array<bool, 2> m_wins;         //player 1 / player 2 has 4 connected stones
 
+    int threat_score(int player, int starter) const;
 };
 
+//the standard board, the one of the game, the opening book and the solver
+using Board = BasicBoard<7, 6>;
+
+extern template class BasicBoard<7, 6>;
+extern template class BasicBoard<8, 7>;
+extern template class BasicBoard<9, 7>;
+
 #endif // BOARD_H
@@ -0,0 +1,233 @@
+#include "board_batch.h"
+
+//the SIMD kernels are compiled for their instruction set with function attributes and chosen at runtime
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BOARD_BATCH_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void eval_scalar(const uint64_t *own, const uint64_t *opponent, std::size_t n, int win, int loose, int depth, int *scores){
+    for(std::size_t i = 0; i < n; ++i){
+        if(Board::has_four(own[i])){
+            scores[i] = win + depth;
+        }
+        else if(Board::has_four(opponent[i])){
+            scores[i] = loose;
+        }
+        else{
+            scores[i] = Board::weighted_sum(own[i]);
+        }
+    }
+}
+
+#ifdef BOARD_BATCH_SIMD
+
+constexpr int COL_BITS = Board::HEIGHT + 1;
+
+//has_four per 64 bit lane, all bits set where the stones contain 4 connected
+__attribute__((target("avx2")))
+inline __m256i has_four_avx2(__m256i stones){
+    __m256i pairs = _mm256_and_si256(stones, _mm256_srli_epi64(stones, 1));
+    __m256i fours = _mm256_and_si256(pairs, _mm256_srli_epi64(pairs, 2));
+    pairs = _mm256_and_si256(stones, _mm256_srli_epi64(stones, COL_BITS - 1));
+    fours = _mm256_or_si256(fours, _mm256_and_si256(pairs, _mm256_srli_epi64(pairs, 2 * (COL_BITS - 1))));
+    pairs = _mm256_and_si256(stones, _mm256_srli_epi64(stones, COL_BITS));
+    fours = _mm256_or_si256(fours, _mm256_and_si256(pairs, _mm256_srli_epi64(pairs, 2 * COL_BITS)));
+    pairs = _mm256_and_si256(stones, _mm256_srli_epi64(stones, COL_BITS + 1));
+    fours = _mm256_or_si256(fours, _mm256_and_si256(pairs, _mm256_srli_epi64(pairs, 2 * (COL_BITS + 1))));
+    __m256i zero = _mm256_setzero_si256();
+    return _mm256_xor_si256(_mm256_cmpeq_epi64(fours, zero), _mm256_cmpeq_epi64(zero, zero));
+}
+
+//popcount of every byte by a nibble lookup table
+__attribute__((target("avx2")))
+inline __m256i byte_popcount_avx2(__m256i x){
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+    __m256i low = _mm256_and_si256(x, low_nibbles);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibbles);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(table, low), _mm256_shuffle_epi8(table, high));
+}
+
+__attribute__((target("avx2")))
+void eval_avx2(const uint64_t *own, const uint64_t *opponent, std::size_t n, int win, int loose, int depth, int *scores){
+    const auto &planes = Board::weight_planes();
+    __m256i plane[Board::WEIGHT_PLANES];
+    for(int k = 0; k < Board::WEIGHT_PLANES; ++k){
+        plane[k] = _mm256_set1_epi64x(static_cast<long long>(planes[k]));
+    }
+    const __m256i win_score = _mm256_set1_epi64x(win + depth);
+    const __m256i loose_score = _mm256_set1_epi64x(loose);
+    const __m256i low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+    std::size_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        __m256i stones = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(own + i));
+        __m256i other = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(opponent + i));
+
+        //weighted byte counts stay below 8 * 15, then one sum of absolute differences adds the bytes of each lane
+        __m256i weighted = byte_popcount_avx2(_mm256_and_si256(stones, plane[0]));
+        for(int k = 1; k < Board::WEIGHT_PLANES; ++k){
+            __m256i count = byte_popcount_avx2(_mm256_and_si256(stones, plane[k]));
+            for(int j = 0; j < k; ++j){
+                count = _mm256_add_epi8(count, count);
+            }
+            weighted = _mm256_add_epi8(weighted, count);
+        }
+        __m256i sum = _mm256_sad_epu8(weighted, _mm256_setzero_si256());
+
+        sum = _mm256_blendv_epi8(sum, loose_score, has_four_avx2(other));
+        sum = _mm256_blendv_epi8(sum, win_score, has_four_avx2(stones));
+        __m256i packed = _mm256_permutevar8x32_epi32(sum, low_halves);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(scores + i), _mm256_castsi256_si128(packed));
+    }
+    eval_scalar(own + i, opponent + i, n - i, win, loose, depth, scores + i);
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i has_four_sse4(__m128i stones){
+    __m128i pairs = _mm_and_si128(stones, _mm_srli_epi64(stones, 1));
+    __m128i fours = _mm_and_si128(pairs, _mm_srli_epi64(pairs, 2));
+    pairs = _mm_and_si128(stones, _mm_srli_epi64(stones, COL_BITS - 1));
+    fours = _mm_or_si128(fours, _mm_and_si128(pairs, _mm_srli_epi64(pairs, 2 * (COL_BITS - 1))));
+    pairs = _mm_and_si128(stones, _mm_srli_epi64(stones, COL_BITS));
+    fours = _mm_or_si128(fours, _mm_and_si128(pairs, _mm_srli_epi64(pairs, 2 * COL_BITS)));
+    pairs = _mm_and_si128(stones, _mm_srli_epi64(stones, COL_BITS + 1));
+    fours = _mm_or_si128(fours, _mm_and_si128(pairs, _mm_srli_epi64(pairs, 2 * (COL_BITS + 1))));
+    __m128i zero = _mm_setzero_si128();
+    return _mm_xor_si128(_mm_cmpeq_epi64(fours, zero), _mm_cmpeq_epi64(zero, zero));
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i byte_popcount_sse4(__m128i x){
+    const __m128i table = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m128i low_nibbles = _mm_set1_epi8(0x0F);
+    __m128i low = _mm_and_si128(x, low_nibbles);
+    __m128i high = _mm_and_si128(_mm_srli_epi16(x, 4), low_nibbles);
+    return _mm_add_epi8(_mm_shuffle_epi8(table, low), _mm_shuffle_epi8(table, high));
+}
+
+__attribute__((target("sse4.1")))
+void eval_sse4(const uint64_t *own, const uint64_t *opponent, std::size_t n, int win, int loose, int depth, int *scores){
+    const auto &planes = Board::weight_planes();
+    __m128i plane[Board::WEIGHT_PLANES];
+    for(int k = 0; k < Board::WEIGHT_PLANES; ++k){
+        plane[k] = _mm_set1_epi64x(static_cast<long long>(planes[k]));
+    }
+    const __m128i win_score = _mm_set1_epi64x(win + depth);
+    const __m128i loose_score = _mm_set1_epi64x(loose);
+
+    std::size_t i = 0;
+    for(; i + 2 <= n; i += 2){
+        __m128i stones = _mm_loadu_si128(reinterpret_cast<const __m128i*>(own + i));
+        __m128i other = _mm_loadu_si128(reinterpret_cast<const __m128i*>(opponent + i));
+
+        __m128i weighted = byte_popcount_sse4(_mm_and_si128(stones, plane[0]));
+        for(int k = 1; k < Board::WEIGHT_PLANES; ++k){
+            __m128i count = byte_popcount_sse4(_mm_and_si128(stones, plane[k]));
+            for(int j = 0; j < k; ++j){
+                count = _mm_add_epi8(count, count);
+            }
+            weighted = _mm_add_epi8(weighted, count);
+        }
+        __m128i sum = _mm_sad_epu8(weighted, _mm_setzero_si128());
+
+        sum = _mm_blendv_epi8(sum, loose_score, has_four_sse4(other));
+        sum = _mm_blendv_epi8(sum, win_score, has_four_sse4(stones));
+        __m128i packed = _mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(scores + i), packed);
+    }
+    eval_scalar(own + i, opponent + i, n - i, win, loose, depth, scores + i);
+}
+
+#endif
+
+}
+
+/**
+ * @brief BoardBatch::add   : appends a position
+ * @param board             : board to evaluate
+ * @param player            : player for which the evaluation is carried out
+ */
+void BoardBatch::add(const Board &board, int player){
+    m_own.push_back(board.get_stones(player));
+    m_opponent.push_back(board.get_stones(3 - player));
+}
+
+/**
+ * @brief BoardBatch::clear : removes all positions, keeps the memory
+ */
+void BoardBatch::clear(){
+    m_own.clear();
+    m_opponent.clear();
+}
+
+/**
+ * @brief BoardBatch::size  : number of positions
+ * @return
+ */
+std::size_t BoardBatch::size() const{
+    return m_own.size();
+}
+
+/**
+ * @brief BoardBatch::eval  : evaluates all positions, scores[i] is Board::eval of position i
+ * @param win               : Value of a win situation
+ * @param loose             : Value of a loose situation
+ * @param depth             : Depth of the evaluation, added to wins
+ * @param scores            : output, size() scores
+ * @param kernel            : instruction set to use, AUTO picks the widest supported, unsupported ones fall back to SCALAR
+ */
+void BoardBatch::eval(int win, int loose, int depth, int *scores, Kernel kernel) const{
+    if(kernel == AUTO){
+        kernel = is_supported(AVX2)? AVX2 : is_supported(SSE4)? SSE4 : SCALAR;
+    }
+    if(!is_supported(kernel)){
+        kernel = SCALAR;
+    }
+#ifdef BOARD_BATCH_SIMD
+    if(kernel == AVX2){
+        eval_avx2(m_own.data(), m_opponent.data(), size(), win, loose, depth, scores);
+        return;
+    }
+    if(kernel == SSE4){
+        eval_sse4(m_own.data(), m_opponent.data(), size(), win, loose, depth, scores);
+        return;
+    }
+#endif
+    eval_scalar(m_own.data(), m_opponent.data(), size(), win, loose, depth, scores);
+}
+
+/**
+ * @brief BoardBatch::is_supported  : true if this build and cpu can run kernel
+ * @param kernel                    : kernel to check
+ * @return
+ */
+bool BoardBatch::is_supported(Kernel kernel){
+    switch(kernel){
+    case AUTO:
+    case SCALAR:
+        return true;
+#ifdef BOARD_BATCH_SIMD
+    case SSE4:
+        return __builtin_cpu_supports("sse4.1");
+    case AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief BoardBatch::get_name  : name of kernel for reports
+ * @param kernel                : kernel
+ * @return
+ */
+const char *BoardBatch::get_name(Kernel kernel){
+    const char *names[] = {"auto", "scalar", "sse4", "avx2"};
+    return names[kernel];
+}
@@ -0,0 +1,37 @@
+#ifndef BOARD_BATCH_H
+#define BOARD_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+
+/**
+ * @brief The BoardBatch class evaluates many positions in one call
+ *
+ * Positions are stored as a structure of arrays: the bitboard of the evaluated player and the one of
+ * the opponent. eval gives exactly Board::eval of every position, with SIMD kernels where the cpu
+ * supports them. They evaluate 2 (SSE4.1) or 4 (AVX2) positions per instruction, the weighted sum
+ * is a byte wise popcount by table lookup.
+ */
+class BoardBatch
+{
+public:
+    enum Kernel {AUTO, SCALAR, SSE4, AVX2};
+
+    void add(const Board &board, int player);
+    void clear();
+    std::size_t size() const;
+
+    void eval(int win, int loose, int depth, int *scores, Kernel kernel = AUTO) const;
+
+    static bool is_supported(Kernel kernel);
+    static const char *get_name(Kernel kernel);
+
+private:
+    std::vector<uint64_t> m_own;        //stones of the evaluated player
+    std::vector<uint64_t> m_opponent;   //stones of the other player
+};
+
+#endif // BOARD_BATCH_H
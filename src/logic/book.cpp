@@ -0,0 +1,161 @@
+#include "book.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char BOOK_MAGIC[8] = {'C', '4', 'B', 'O', 'O', 'K', '\0', '\0'};
+constexpr uint32_t BOOK_VERSION = 2;
+
+static_assert(sizeof(Book::Header) == 32, "book header must match the file layout");
+static_assert(sizeof(Book::Entry) == 16, "book entry must match the file layout");
+
+}
+
+/**
+ * @brief Book::Book    : creates an empty book
+ */
+Book::Book():
+    m_entries(nullptr),
+    m_count(0),
+    m_plies(0),
+    m_evaluation(0)
+{}
+
+/**
+ * @brief Book::~Book   : unmaps the book file
+ */
+Book::~Book()
+{}
+
+/**
+ * @brief Book::open    : maps the book file, only the header is read
+ * @param path          : book file
+ * @return              : true if the file is a valid book
+ */
+bool Book::open(const std::string &path){
+    m_entries = nullptr;
+    m_count = 0;
+    if(!m_file.open(path) || m_file.size() < sizeof(Header)){
+        m_file.close();
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, m_file.data(), sizeof(Header));
+    //compare the count before the sizes, a corrupt count must not overflow the expected size
+    if(std::memcmp(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 || header.version != BOOK_VERSION
+            || header.count > (m_file.size() - sizeof(Header)) / sizeof(Entry)
+            || m_file.size() != sizeof(Header) + header.count * sizeof(Entry)){
+        m_file.close();
+        return false;
+    }
+
+    m_entries = reinterpret_cast<const Entry *>(m_file.data() + sizeof(Header));
+    m_count = std::size_t(header.count);
+    m_plies = int(header.plies);
+    m_evaluation = int(header.evaluation);
+    return true;
+}
+
+/**
+ * @brief Book::is_open : true if a book file is mapped
+ * @return
+ */
+bool Book::is_open() const{
+    return m_entries != nullptr;
+}
+
+/**
+ * @brief Book::canonical_key   : key of the position for player to move, the smaller one of the position and its mirror
+ * @param board                 : current board
+ * @param player                : player to move
+ * @param mirrored              : set to true if the key is the one of the mirrored position
+ * @return
+ */
+uint64_t Book::canonical_key(const Board &board, int player, bool &mirrored){
+    uint64_t key = board.player_key(player);
+    uint64_t mirror_key = board.mirrored_player_key(player);
+    mirrored = mirror_key < key;
+    return mirrored? mirror_key : key;
+}
+
+/**
+ * @brief Book::lookup  : binary search for the position in the mapped entries
+ * @param board         : current board
+ * @param player        : player to move
+ * @param move          : best move if found
+ * @param score         : score of the best move for player if found
+ * @param depth         : search depth of the entry if found
+ * @return              : true if the position is in the book
+ */
+bool Book::lookup(const Board &board, int player, int &move, int &score, int &depth) const{
+    if(!is_open()){
+        return false;
+    }
+    bool mirrored;
+    uint64_t key = canonical_key(board, player, mirrored);
+    const Entry *end = m_entries + m_count;
+    const Entry *entry = std::lower_bound(m_entries, end, key, [](const Entry &e, uint64_t k){return e.key < k;});
+    if(entry == end || entry->key != key){
+        return false;
+    }
+    move = mirrored? Board::WIDTH - 1 - entry->move : entry->move;
+    score = entry->score;
+    depth = entry->depth;
+    return true;
+}
+
+/**
+ * @brief Book::size    : number of positions in the book
+ * @return
+ */
+std::size_t Book::size() const{
+    return m_count;
+}
+
+/**
+ * @brief Book::get_plies   : the book contains all positions up to this number of stones
+ * @return
+ */
+int Book::get_plies() const{
+    return m_plies;
+}
+
+/**
+ * @brief Book::get_evaluation  : evaluation the book was searched with, an Ai::Evaluation
+ * @return
+ */
+int Book::get_evaluation() const{
+    return m_evaluation;
+}
+
+/**
+ * @brief Book::write   : sorts the entries and writes them as book file, of duplicate keys the deepest entry is kept
+ * @param path          : book file
+ * @param entries       : entries with canonical keys
+ * @param plies         : maximal number of stones of the positions
+ * @param evaluation    : Ai::Evaluation the entries were searched with
+ * @return              : true on success
+ */
+bool Book::write(const std::string &path, std::vector<Entry> entries, int plies, int evaluation){
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b){
+        return a.key < b.key || (a.key == b.key && a.depth > b.depth);
+    });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry &a, const Entry &b){return a.key == b.key;}),
+                  entries.end());
+
+    Header header;
+    std::memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    header.version = BOOK_VERSION;
+    header.plies = uint32_t(plies);
+    header.count = entries.size();
+    header.evaluation = uint32_t(evaluation);
+    header.reserved = 0;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    out.write(reinterpret_cast<const char *>(entries.data()), std::streamsize(entries.size() * sizeof(Entry)));
+    return bool(out);
+}
@@ -0,0 +1,60 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "mapped_file.h"
+
+/**
+ * @brief The Book class is a precomputed opening book, a sorted binary file which is memory mapped and binary searched
+ *
+ * File layout (little endian): Header, then Header::count entries sorted by key. Keys are the smaller of
+ * Board::player_key and Board::mirrored_player_key, so a position and its mirror share one entry. The stored
+ * move belongs to the position with the smaller key and is mirrored on lookup if necessary. The header names the
+ * evaluation the book was searched with, an ai only plays book moves of its own evaluation.
+ */
+class Book
+{
+public:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t plies;
+        uint64_t count;
+        uint32_t evaluation;    //Ai::Evaluation of the searches
+        uint32_t reserved;
+    };
+
+    struct Entry {
+        uint64_t key;
+        int16_t score;      //score of the player to move
+        uint8_t move;
+        uint8_t depth;      //search depth the entry was computed with
+        uint32_t reserved;
+    };
+
+    Book();
+    ~Book();
+
+    bool open(const std::string &path);
+    bool is_open() const;
+    bool lookup(const Board &board, int player, int &move, int &score, int &depth) const;
+    std::size_t size() const;
+    int get_plies() const;
+    int get_evaluation() const;
+
+    static uint64_t canonical_key(const Board &board, int player, bool &mirrored);
+    static bool write(const std::string &path, std::vector<Entry> entries, int plies, int evaluation);
+
+private:
+    MappedFile m_file;
+    const Entry *m_entries;
+    std::size_t m_count;
+    int m_plies;
+    int m_evaluation;
+};
+
+#endif // BOOK_H
@@ -0,0 +1,146 @@
+#include "dataset.h"
+
+#include <cstring>
+
+namespace {
+
+const char DATASET_MAGIC[8] = {'C', '4', 'D', 'A', 'T', 'A', '\0', '\0'};
+constexpr uint32_t DATASET_VERSION = 1;
+
+static_assert(sizeof(Dataset::Header) == 24, "dataset header must match the file layout");
+static_assert(sizeof(Dataset::Entry) == 16, "dataset entry must match the file layout");
+
+}
+
+/**
+ * @brief Dataset::Dataset  : creates an empty dataset
+ */
+Dataset::Dataset():
+    m_entries(nullptr),
+    m_count(0)
+{
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+/**
+ * @brief Dataset::~Dataset : unmaps the file
+ */
+Dataset::~Dataset()
+{}
+
+/**
+ * @brief Dataset::open : maps a dataset file, only the header is read
+ * @param path          : dataset file
+ * @return              : true if the file is a dataset of this version
+ */
+bool Dataset::open(const std::string &path){
+    close();
+    if(!m_file.open(path) || m_file.size() < sizeof(Header)){
+        m_file.close();
+        return false;
+    }
+    std::memcpy(&m_header, m_file.data(), sizeof(Header));
+    if(!valid_header(m_header)){
+        m_file.close();
+        return false;
+    }
+    m_entries = reinterpret_cast<const Entry *>(m_file.data() + sizeof(Header));
+    m_count = (m_file.size() - sizeof(Header)) / sizeof(Entry);
+    return true;
+}
+
+/**
+ * @brief Dataset::close    : unmaps the file
+ */
+void Dataset::close(){
+    m_file.close();
+    m_entries = nullptr;
+    m_count = 0;
+}
+
+/**
+ * @brief Dataset::is_open  : true if a dataset is mapped
+ * @return
+ */
+bool Dataset::is_open() const{
+    return m_entries != nullptr;
+}
+
+/**
+ * @brief Dataset::size : number of complete entries
+ * @return
+ */
+std::size_t Dataset::size() const{
+    return m_count;
+}
+
+/**
+ * @brief Dataset::get_entry    : entry in the mapped file
+ * @param index                 : < size()
+ * @return
+ */
+const Dataset::Entry &Dataset::get_entry(std::size_t index) const{
+    return m_entries[index];
+}
+
+/**
+ * @brief Dataset::get_header   : header of the mapped file with the settings of the sampling
+ * @return
+ */
+const Dataset::Header &Dataset::get_header() const{
+    return m_header;
+}
+
+/**
+ * @brief Dataset::make_header  : header of a new dataset file
+ * @param seed                  : seed of the sampling
+ * @param min_ply               : fewest stones of a sampled position
+ * @param max_ply               : most stones of a sampled position
+ * @param depth                 : depth of the self-play ai
+ * @return
+ */
+Dataset::Header Dataset::make_header(uint32_t seed, int min_ply, int max_ply, int depth){
+    Header header;
+    std::memcpy(header.magic, DATASET_MAGIC, sizeof(DATASET_MAGIC));
+    header.version = DATASET_VERSION;
+    header.seed = seed;
+    header.min_ply = uint16_t(min_ply);
+    header.max_ply = uint16_t(max_ply);
+    header.depth = uint16_t(depth);
+    header.reserved = 0;
+    return header;
+}
+
+/**
+ * @brief Dataset::valid_header : true if header is the one of a dataset of this version
+ * @param header                : header read from a file
+ * @return
+ */
+bool Dataset::valid_header(const Header &header){
+    return std::memcmp(header.magic, DATASET_MAGIC, sizeof(DATASET_MAGIC)) == 0 && header.version == DATASET_VERSION;
+}
+
+/**
+ * @brief Dataset::decode   : position of an entry, the key holds the stones of the player to move plus all stones
+ *                            per column all stones are the lowest bits, so key + bottom bit of the column has
+ *                            its highest bit right above the column
+ * @param entry             : entry of the dataset
+ * @param player            : set to the player to move
+ * @return                  : board with the stones of both players
+ */
+Board Dataset::decode(const Entry &entry, int &player){
+    player = (entry.ply % 2 == 0)? 1 : 2;
+    Board board;
+    for(int col = 0; col < Board::WIDTH; ++col){
+        uint64_t column = (entry.key >> (col * (Board::HEIGHT + 1))) & ((uint64_t(1) << (Board::HEIGHT + 1)) - 1);
+        int height = 0;
+        while((column + 1) >> (height + 1)){
+            ++height;
+        }
+        uint64_t own = column + 1 - (uint64_t(1) << height);
+        for(int row = 0; row < height; ++row){
+            board.drop(col, ((own >> row) & 1)? player : 3 - player);
+        }
+    }
+    return board;
+}
@@ -0,0 +1,63 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "board.h"
+#include "mapped_file.h"
+
+/**
+ * @brief The Dataset class is a file of solved positions generated by connect4_dataset, memory mapped and read in place
+ *
+ * File layout (little endian): Header, then fixed size entries in the order they were sampled. Keys are
+ * Board::player_key of the player to move, player 1 makes the first move, so the ply tells the colors.
+ * A trailing partial entry (an interrupted append) is ignored and cut off by the generator when it resumes.
+ */
+class Dataset
+{
+public:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t seed;          //settings of the sampling, a resumed run must use the same
+        uint16_t min_ply;
+        uint16_t max_ply;
+        uint16_t depth;         //depth of the self-play ai
+        uint16_t reserved;
+    };
+
+    struct Entry {
+        uint64_t key;
+        int8_t score;           //exact score of the player to move, see Solver
+        uint8_t move;           //best move
+        uint8_t ply;            //stones on the board
+        uint8_t source;         //RANDOM or SELF_PLAY
+        uint32_t nodes;         //nodes of the solver, saturated
+    };
+
+    enum Source {RANDOM, SELF_PLAY};
+
+    Dataset();
+    ~Dataset();
+
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+    std::size_t size() const;
+    const Entry &get_entry(std::size_t index) const;
+    const Header &get_header() const;
+
+    static Header make_header(uint32_t seed, int min_ply, int max_ply, int depth);
+    static bool valid_header(const Header &header);
+    static Board decode(const Entry &entry, int &player);
+
+private:
+    MappedFile m_file;
+    Header m_header;
+    const Entry *m_entries;
+    std::size_t m_count;
+};
+
+#endif // DATASET_H
@@ -1,67 +1,242 @@
 #include "game.h"
 
+//opening book used by the ais if it exists in the working directory, see connect4_book
+static const char BOOK_FILE[] = "connect4.book";
+
 /**
- * @brief Game::Game: Constructor for the Game class, setting up a game environment
+ * @brief Game::Game: Constructor for the Game class, setting up a game environment and starting its worker
  * @param iForm     : observer for callbaks on form
  * @param p1_is_ai  : defines if player 1 is an ai
  * @param p2_is_ai  : defines if player 2 is an ai
  * @param p1_depth  : defines depth of player 1 (if it is an ai)
  * @param p2_depth  : defines depth of player 2 (if it is an ai)
  * @param p_start   : defines which player to start
+ * @param p1_budget_ms  : time budget per move of player 1 in ms, 0 to search to p1_depth instead
+ * @param p2_budget_ms  : time budget per move of player 2 in ms, 0 to search to p2_depth instead
  */
-Game::Game(Observer* iForm, bool p1_is_ai, bool p2_is_ai, int p1_depth, int p2_depth, int p_start):
-    m_iForm(iForm)
+Game::Game(Observer* iForm, bool p1_is_ai, bool p2_is_ai, int p1_depth, int p2_depth, int p_start,
+           unsigned p1_budget_ms, unsigned p2_budget_ms):
+    game_over(false),
+    m_iForm(iForm),
+    m_current_player(p_start),
+    m_ponder_pending(false),
+    m_stopped(false)
 {
     m_p1_is_ai = p1_is_ai;
     m_p2_is_ai = p2_is_ai;
     m_p1_depth = p1_depth;
     m_p2_depth = p2_depth;
+    m_p1_budget_ms = p1_budget_ms;
+    m_p2_budget_ms = p2_budget_ms;
     m_p1_time = 0;
     m_p2_time = 0;
     m_p_start = p_start;
-    m_current_player = p_start;
-    game_over = false;
+
+    //settings of the game record
+    m_record.ai[0] = p1_is_ai;
+    m_record.ai[1] = p2_is_ai;
+    m_record.depth[0] = p1_is_ai? p1_depth : 0;
+    m_record.depth[1] = p2_is_ai? p2_depth : 0;
+    m_record.budget_ms[0] = p1_is_ai? p1_budget_ms : 0;
+    m_record.budget_ms[1] = p2_is_ai? p2_budget_ms : 0;
+    m_record.start = p_start;
 
     //generate ais if necessary
     if(m_p1_is_ai){
         m_ai_1.reset(new Ai(m_p1_depth, 1));
+        m_ai_1->set_threads(0);
+        m_ai_1->load_book(BOOK_FILE);
     }
     if(m_p2_is_ai){
         m_ai_2.reset(new Ai(m_p2_depth, 2));
+        m_ai_2->set_threads(0);
+        m_ai_2->load_book(BOOK_FILE);
     }
+
+    //pass the intermediate results of the searches on to the form, cancel the searches on reset and stop
+    if(m_ai_1){
+        m_ai_1->set_progress_callback([this](const SearchProgress &progress){m_iForm->updateSearchProgress(1, progress);});
+        m_ai_1->set_stop_token(m_search_stop.get_token());
+    }
+    if(m_ai_2){
+        m_ai_2->set_progress_callback([this](const SearchProgress &progress){m_iForm->updateSearchProgress(2, progress);});
+        m_ai_2->set_stop_token(m_search_stop.get_token());
+    }
+
+    m_worker = std::thread(&Game::run, this);
 }
 
 /**
- * @brief Game::~Game   : empty destructor
+ * @brief Game::~Game   : stops the game and joins the worker, a running search is cancelled, the form gets no more callbacks
+ *                        an unfinished game is still written to the record file
  */
 Game::~Game()
-{}
+{
+    stop();
+    m_worker.join();
+}
 
 /**
- * @brief Game::start: Starts the game: calls ai if ai starts, otherwise do nothing (wait for user input)
+ * @brief Game::set_record_file: appends the game to a game record file when it ends (or is stopped before), see GameRecord
+ *                               must be called before start
+ * @param path                 : record file, created if it does not exist
+ * @return                     : false if the file can't be written
+ */
+bool Game::set_record_file(const std::string &path){
+    return m_record_writer.open(path);
+}
+
+/**
+ * @brief Game::set_evaluation: evaluation of the leaves of both ais, Ai::POSITIONAL by default. Must be called before start
+ * @param evaluation          : evaluation of the ais, the opening book is only used if it was searched with the same one
+ */
+void Game::set_evaluation(Ai::Evaluation evaluation){
+    for(Ai *ai : {m_ai_1.get(), m_ai_2.get()}){
+        if(ai){
+            ai->set_evaluation(evaluation);
+        }
+    }
+}
+
+/**
+ * @brief Game::start: Starts the game: the ai moves if it starts, otherwise it ponders while waiting for user input
  */
 void Game::start(){
-    if((m_p_start == 1 && m_p1_is_ai) || (m_p_start==2 && m_p2_is_ai))
-    {
+    post({START, 0}, false);
+}
+
+/**
+ * @brief Game::human_move: queues a move of the human, ignored by the worker if it is not the human's turn or the column is full
+ * @param pos: defines the next move
+ */
+void Game::human_move(int pos){
+    post({HUMAN_MOVE, pos}, false);
+}
+
+/**
+ * @brief Game::reset: cancels a running search and empties the board for a new game with the same settings, which begins with start
+ *                     an unfinished game is written to the record file
+ */
+void Game::reset(){
+    post({RESET, 0}, true);
+}
+
+/**
+ * @brief Game::stop: cancels a running search and ends the worker, the commands queued later are dropped
+ */
+void Game::stop(){
+    post({STOP, 0}, true);
+}
+
+/**
+ * @brief Game::get_current_player: get number of current player
+ */
+int Game::get_current_player(){
+    return m_current_player;
+}
+
+/**
+ * @brief Game::post        : queues a command for the worker and ends pondering, so the worker takes it at once
+ * @param command           : command to queue
+ * @param cancel_search     : true to cancel a running ai search too
+ */
+void Game::post(Command command, bool cancel_search){
+    std::lock_guard<std::mutex> guard(m_queue_mutex);
+    if(m_stopped){
+        return;
+    }
+    m_stopped = command.type == STOP;
+    m_queue.push_back(command);
+    if(cancel_search){
+        m_search_stop.request_stop();
+    }
+    m_ponder_stop.request_stop();
+    m_queue_changed.notify_one();
+}
+
+/**
+ * @brief Game::run: loop of the worker, handles the commands in order and ponders while the queue is empty
+ */
+void Game::run(){
+    while(true){
+        Command command;
+        {
+            std::unique_lock<std::mutex> lock(m_queue_mutex);
+            if(m_queue.empty() && m_ponder_pending){
+                //a command posted from now on stops pondering
+                m_ponder_pending = false;
+                m_ponder_stop = StopSource();
+                lock.unlock();
+                ponder();
+                continue;
+            }
+            m_queue_changed.wait(lock, [this]{return !m_queue.empty();});
+            command = m_queue.front();
+            m_queue.pop_front();
+        }
+        if(!handle(command)){
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Game::handle  : executes one command on the worker
+ * @param command       : command taken from the queue
+ * @return              : false after STOP
+ */
+bool Game::handle(const Command &command){
+    switch(command.type){
+    case START:
+        if(is_ai(m_current_player)){
+            ai_move();
+        }
+        else{
+            m_ponder_pending = true;
+        }
+        return true;
+    case HUMAN_MOVE:
+        play_human_move(command.pos);
+        return true;
+    case AI_MOVE:
         ai_move();
+        return true;
+    case RESET:
+        reset_game();
+        return true;
+    case STOP:
+        //archive a game which was stopped before its end
+        if(!game_over && !m_record.moves.empty()){
+            write_record(GameRecord::UNFINISHED);
+        }
+        return false;
     }
+    return true;
+}
+
+/**
+ * @brief Game::is_ai   : true if player is played by an ai
+ * @param player        : 1 or 2
+ * @return
+ */
+bool Game::is_ai(int player) const{
+    return (player == 1 && m_p1_is_ai) || (player == 2 && m_p2_is_ai);
 }
 
 /**
  * @brief Game::ai_move: Get a move from the ai, execute it, evaluate board, proceed with ai or human
  */
 void Game::ai_move(){
-    // Wait for human move to finish
-    std::mutex huMu;
-    std::unique_lock<std::mutex> aiLock(huMu);
-    m_aiPlayer.wait(aiLock,[this]{return (m_current_player == 1 && m_p1_is_ai) || (m_current_player == 2 && m_p2_is_ai);});
+    if(game_over || !is_ai(m_current_player)){
+        return;
+    }
 
     //get the move, measure execution time
-    std::pair<int, int> aipair;
+    Ai::SearchResult result;
     int t_delta;
     if(m_current_player == 1){
         auto t_start = std::chrono::high_resolution_clock::now();
-        aipair = m_ai_1->get_move(m_board);
+        result = m_ai_1->search(m_board, m_p1_budget_ms);
         auto t_end = std::chrono::high_resolution_clock::now();
         t_delta = std::chrono::duration_cast<std::chrono::milliseconds>(t_end-t_start).count();
 
@@ -70,7 +245,7 @@ void Game::ai_move(){
     }
     else{
         auto t_start = std::chrono::high_resolution_clock::now();
-        aipair = m_ai_2->get_move(m_board);
+        result = m_ai_2->search(m_board, m_p2_budget_ms);
         auto t_end = std::chrono::high_resolution_clock::now();
         t_delta = std::chrono::duration_cast<std::chrono::milliseconds>(t_end-t_start).count();
 
@@ -78,101 +253,163 @@ void Game::ai_move(){
         m_p2_time += t_delta;
     }
 
+    //the game is reset or stopped, the result of the cancelled search is not needed
+    {
+        std::lock_guard<std::mutex> guard(m_queue_mutex);
+        if(m_search_stop.stop_requested()){
+            return;
+        }
+    }
+
     //execute move and callback to form
-    m_board.drop(aipair.first, m_current_player);
+    m_board.drop(result.move, m_current_player);
+    m_record.add_move(result.move, t_delta, result.score);
     m_iForm->updatePositions(m_board.get_positions());
 
     //write move and time to output list
-    m_iForm->writeToLog("player " + QString::number(m_current_player) + ": " + QString::number(aipair.first));
-    m_iForm->writeToLog("score: " + QString::number(aipair.second));
+    m_iForm->writeToLog("player " + std::to_string(m_current_player) + ": " + std::to_string(result.move));
+    m_iForm->writeToLog("score: " + std::to_string(result.score));
+    m_iForm->writeToLog("depth: " + std::to_string(result.stats.depth));
     if(t_delta >= 1000){
         t_delta /= 1000;
-        m_iForm->writeToLog("time: " + QString::number(t_delta) + " s");
+        m_iForm->writeToLog("time: " + std::to_string(t_delta) + " s");
     }
     else{
-        m_iForm->writeToLog("time: " + QString::number(t_delta) + " ms");
+        m_iForm->writeToLog("time: " + std::to_string(t_delta) + " ms");
     }
+    m_iForm->updateSearchStats(m_current_player, result.stats);
 
     m_iForm->writeToLog("------------------");
 
     //eval board, if player won or game finish callback on form and write to output list
     if(m_board.is_winner(m_current_player)){
-        m_iForm->writeToLog("player " + QString::number(m_current_player) + " wins");
+        m_iForm->writeToLog("player " + std::to_string(m_current_player) + " wins");
         m_iForm->writeToLog("------------------");
         final_time();
         game_over = true;
+        write_record(m_current_player);
         m_iForm->gameOver(m_current_player);
         m_iForm->setWinningLine(m_board.get_winning_line(m_current_player));
     }
     else if (m_board.is_full()) {
         final_time();
         game_over = true;
+        write_record(0);
         m_iForm->gameOver(0);
     }
     else{//proceed in game with next player
-          m_current_player = 3 - m_current_player;
-         if((m_current_player == 1 && m_p1_is_ai) || (m_current_player == 2 && m_p2_is_ai)){
-             std::thread t(&Game::ai_move,this);
-             t.detach();
+         m_current_player = 3 - m_current_player;
+         if(is_ai(m_current_player)){//queued, so a reset or stop in between is handled first
+             post({AI_MOVE, 0}, false);
          }
-         else{//human move
+         else{//human move, the ai searches the replies meanwhile
+             m_ponder_pending = true;
              m_iForm->updatePossibleDrops(m_board.possible_drops());
          }
     }
-    // ai move done
-    m_aiPlayer.notify_one();
 }
 
 /**
- * @brief Game::human_move: Execute a human move, evaluate board, proceed with ai or human
+ * @brief Game::play_human_move: Execute a human move, evaluate board, proceed with ai or human
  * @param pos: defines the next move
  */
-void Game::human_move(int pos){
-    // Wait for ai_move to finish
-    std::mutex aiMu;
-    std::unique_lock<std::mutex> aiLock(aiMu);
-    m_aiPlayer.wait(aiLock,[this]{return !((m_current_player == 1 && m_p1_is_ai) || (m_current_player == 2 && m_p2_is_ai));});
+void Game::play_human_move(int pos){
+    if(game_over || is_ai(m_current_player) || pos < 0 || pos >= Board::WIDTH || m_board.get_height(pos) == Board::HEIGHT){
+        m_iForm->writeToLog("P" + std::to_string(m_current_player) + " : " + std::to_string(pos) + " - invalid");
+        m_iForm->writeToLog("------------------");
+        return;
+    }
 
     //execute move, callback on form
     m_board.drop(pos, m_current_player);
+    m_record.add_move(pos, 0, 0);
     m_iForm->updatePositions(m_board.get_positions());
 
     //write move to output list
-    m_iForm->writeToLog("P" + QString::number(m_current_player) + " : " + QString::number(pos));
+    m_iForm->writeToLog("P" + std::to_string(m_current_player) + " : " + std::to_string(pos));
     m_iForm->writeToLog("------------------");
 
     //evaluate board, if player won or game finish callback on form and write to output list
     if(m_board.is_winner(m_current_player)){
-        m_iForm->writeToLog("player " + QString::number(m_current_player) + " wins");
+        m_iForm->writeToLog("player " + std::to_string(m_current_player) + " wins");
         m_iForm->writeToLog("------------------");
         final_time();
         game_over = true;
+        write_record(m_current_player);
         m_iForm->gameOver(m_current_player);
         m_iForm->setWinningLine(m_board.get_winning_line(m_current_player));
     }
-    else if (m_board.is_full()) {
+    else if (m_board.is_full()) {//draw
+        final_time();
         game_over = true;
-        m_iForm->gameOver(m_current_player);
+        write_record(0);
+        m_iForm->gameOver(0);
     }
     else{//proceed in game with next player
           m_current_player = 3 - m_current_player;
-         if((m_current_player == 1 && m_p1_is_ai) || (m_current_player == 2 && m_p2_is_ai)){
-              std::thread t(&Game::ai_move,this);
-              t.detach();
+         if(is_ai(m_current_player)){
+             post({AI_MOVE, 0}, false);
          }
          else{//human move
              m_iForm->updatePossibleDrops(m_board.possible_drops());
          }
     }
-    // human move done
-    m_aiPlayer.notify_one();
 }
 
 /**
- * @brief Game::get_current_player: get number of current player
+ * @brief Game::reset_game: empties the board and the record, the searches of the ais can run again
  */
-int Game::get_current_player(){
-    return m_current_player;
+void Game::reset_game(){
+    //archive a game which was reset before its end
+    if(!game_over && !m_record.moves.empty()){
+        write_record(GameRecord::UNFINISHED);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_queue_mutex);
+        m_search_stop = StopSource();
+    }
+    for(Ai *ai : {m_ai_1.get(), m_ai_2.get()}){
+        if(ai){
+            ai->set_stop_token(m_search_stop.get_token());
+        }
+    }
+
+    m_board.reset();
+    m_record.result = GameRecord::UNFINISHED;
+    m_record.moves.clear();
+    m_record.time_ms.clear();
+    m_record.scores.clear();
+    m_p1_time = 0;
+    m_p2_time = 0;
+    m_current_player = m_p_start;
+    m_ponder_pending = false;
+    game_over = false;
+
+    m_iForm->updatePositions(m_board.get_positions());
+    m_iForm->updatePossibleDrops(m_board.possible_drops());
+}
+
+/**
+ * @brief Game::ponder: lets the ai of the other player search the replies of the human to move,
+ *                      its get_move answers a pondered reply without search. Returns once a command is posted
+ */
+void Game::ponder(){
+    Ai *ai = (m_current_player == 1)? m_ai_2.get() : m_ai_1.get();
+    if(ai && !game_over){
+        ai->ponder(m_board, m_ponder_stop.get_token());
+    }
+}
+
+/**
+ * @brief Game::write_record: writes the game to the record file if there is one
+ * @param result            : winner, 0 for a draw, GameRecord::UNFINISHED
+ */
+void Game::write_record(int result){
+    m_record.result = result;
+    if(m_record_writer.is_open()){
+        m_record_writer.append(m_record);
+    }
 }
 
 /**
@@ -183,23 +420,20 @@ void Game::final_time(){
         m_iForm->writeToLog("player 1 \ntotal time:");
         if(m_p1_time >= 1000){
             m_p1_time /= 1000;
-            m_iForm->writeToLog(QString::number(m_p1_time) + " s\n");
+            m_iForm->writeToLog(std::to_string(m_p1_time) + " s\n");
         }
         else {
-            m_iForm->writeToLog(QString::number(m_p1_time) + " ms\n");
+            m_iForm->writeToLog(std::to_string(m_p1_time) + " ms\n");
         }
     }
     if (m_p2_is_ai) {
         m_iForm->writeToLog("player 2  \ntotal time:");
         if(m_p2_time >= 1000){
             m_p2_time /= 1000;
-            m_iForm->writeToLog(QString::number(m_p2_time) + " s\n");
+            m_iForm->writeToLog(std::to_string(m_p2_time) + " s\n");
         }
         else {
-            m_iForm->writeToLog(QString::number(m_p2_time) + " ms\n");
+            m_iForm->writeToLog(std::to_string(m_p2_time) + " ms\n");
         }
     }
 }
-
-
-
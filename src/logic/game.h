@@ -1,32 +1,56 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <chrono>
-#include <future>
 
 #include "board.h"
 #include "ai.h"
 #include "observer.h"
+#include "game_record.h"
+#include "stop_token.h"
 
 
 /**
  * @brief The Game class manages the whole game procedure, gives callbacks to form to update the GUI
+ *
+ * Every game has one worker thread which owns the board, the ais and the record. start, human_move, reset and stop
+ * only queue a command and return, so the caller never waits for a search. The worker handles the commands in order,
+ * searches the ai moves and lets the ai ponder while the human is to move and no command is waiting. The observer is
+ * called from the worker. reset and stop cancel a running search at once, the destructor stops the game and joins the worker.
  */
 class Game
 {
 
 public:
-    Game(Observer* iForm, bool p1_is_ai, bool p2_is_ai, int p1_depth, int p2_depth, int p_start);
+    Game(Observer* iForm, bool p1_is_ai, bool p2_is_ai, int p1_depth, int p2_depth, int p_start,
+         unsigned p1_budget_ms = 0, unsigned p2_budget_ms = 0);
     ~Game();
 
-    bool game_over;
+    std::atomic<bool> game_over;
 
+    bool set_record_file(const std::string &path);
+    void set_evaluation(Ai::Evaluation evaluation);
     void start();
-    int get_current_player();
     void human_move(int pos);
+    void reset();
+    void stop();
+    int get_current_player();
 
 private:
+    //commands of the worker, AI_MOVE is queued by the worker itself so commands between two ai moves are handled
+    enum CommandType {START, HUMAN_MOVE, AI_MOVE, RESET, STOP};
+
+    struct Command {
+        CommandType type;
+        int pos;    //column of HUMAN_MOVE
+    };
+
     Board m_board;
 
 
@@ -39,15 +63,37 @@ private:
     bool m_p2_is_ai;
     int m_p1_depth;
     int m_p2_depth;
+    unsigned m_p1_budget_ms;
+    unsigned m_p2_budget_ms;
     unsigned m_p1_time;
     unsigned m_p2_time;
     int m_p_start;
-    int m_current_player;
+    std::atomic<int> m_current_player;
+
+    //moves, times and scores of the game, appended to the record file at the end
+    GameRecord m_record;
+    GameRecordWriter m_record_writer;
 
+    void post(Command command, bool cancel_search);
+    void run();
+    bool handle(const Command &command);
     void ai_move();
+    void play_human_move(int pos);
+    void reset_game();
+    void ponder();
+    bool is_ai(int player) const;
     void final_time();
+    void write_record(int result);
 
-    std::condition_variable m_aiPlayer;
+    //command queue of the worker, a new command also ends pondering
+    std::mutex m_queue_mutex;
+    std::condition_variable m_queue_changed;
+    std::deque<Command> m_queue;
+    StopSource m_search_stop;   //cancels the searches of the ais, replaced on reset
+    StopSource m_ponder_stop;   //ends pondering once a command arrives
+    bool m_ponder_pending;      //the human is to move and the ai has not pondered yet, worker only
+    bool m_stopped;             //a STOP command was queued, later commands are dropped
+    std::thread m_worker;
 };
 
 #endif // GAME_H
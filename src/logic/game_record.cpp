@@ -0,0 +1,418 @@
+#include "game_record.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+const char RECORD_MAGIC[8] = {'C', '4', 'G', 'A', 'M', 'E', 'S', '\0'};
+constexpr uint32_t RECORD_VERSION = 1;
+constexpr int BITS_PER_MOVE = 3;
+
+static_assert(sizeof(GameRecordReader::FileHeader) == 16, "file header must match the file layout");
+static_assert(sizeof(GameRecordView::Header) == 10, "record header must match the file layout");
+static_assert(sizeof(GameRecordView::MoveInfo) == 4, "move info must match the file layout");
+static_assert(Board::WIDTH <= (1 << BITS_PER_MOVE), "a column must fit into the bits of a move");
+
+std::size_t packed_moves_size(int plies){
+    return std::size_t(plies * BITS_PER_MOVE + 7) / 8;
+}
+
+//true if a complete record starts at pos
+bool valid_record(const unsigned char *pos, const unsigned char *end){
+    if(std::size_t(end - pos) < sizeof(GameRecordView::Header)){
+        return false;
+    }
+    GameRecordView::Header header;
+    std::memcpy(&header, pos, sizeof(header));
+    return header.plies <= Board::WIDTH * Board::HEIGHT && header.size == GameRecordView::record_size(header.plies)
+            && std::size_t(end - pos) >= header.size;
+}
+
+}
+
+/**
+ * @brief GameRecord::add_move  : appends a move of the game
+ * @param col                   : column of the move
+ * @param move_time_ms          : search time of an ai move, 0 for a human
+ * @param score                 : score of an ai move, 0 for a human
+ */
+void GameRecord::add_move(int col, unsigned move_time_ms, int score){
+    moves.push_back(col);
+    time_ms.push_back(move_time_ms);
+    scores.push_back(score);
+}
+
+/**
+ * @brief GameRecordView::GameRecordView    : view of the record starting at data, which must be complete
+ * @param data                              : first byte of the record
+ */
+GameRecordView::GameRecordView(const unsigned char *data):
+    m_data(data)
+{
+    if(m_data){
+        std::memcpy(&m_header, m_data, sizeof(m_header));
+    }
+    else{
+        std::memset(&m_header, 0, sizeof(m_header));
+    }
+}
+
+/**
+ * @brief GameRecordView::record_size   : bytes of a record with plies moves
+ * @param plies                         : number of moves
+ * @return
+ */
+std::size_t GameRecordView::record_size(int plies){
+    return sizeof(Header) + packed_moves_size(plies) + plies * sizeof(MoveInfo);
+}
+
+/**
+ * @brief GameRecordView::size  : bytes of this record
+ * @return
+ */
+std::size_t GameRecordView::size() const{
+    return m_header.size;
+}
+
+/**
+ * @brief GameRecordView::get_plies : number of moves of the game
+ * @return
+ */
+int GameRecordView::get_plies() const{
+    return m_header.plies;
+}
+
+/**
+ * @brief GameRecordView::is_ai : true if player was an ai
+ * @param player                : 1 or 2
+ * @return
+ */
+bool GameRecordView::is_ai(int player) const{
+    return (m_header.flags >> (player - 1)) & 1;
+}
+
+/**
+ * @brief GameRecordView::get_depth : search depth of player, 0 for a human
+ * @param player                    : 1 or 2
+ * @return
+ */
+int GameRecordView::get_depth(int player) const{
+    return m_header.depth[player - 1];
+}
+
+/**
+ * @brief GameRecordView::get_budget_ms : time budget per move of player, 0 if it searched to its depth
+ * @param player                        : 1 or 2
+ * @return
+ */
+unsigned GameRecordView::get_budget_ms(int player) const{
+    return m_header.budget_ms[player - 1];
+}
+
+/**
+ * @brief GameRecordView::get_start : player of the first move
+ * @return
+ */
+int GameRecordView::get_start() const{
+    return ((m_header.flags >> 2) & 1) + 1;
+}
+
+/**
+ * @brief GameRecordView::get_result    : winner, 0 for a draw, GameRecord::UNFINISHED if the game was aborted
+ * @return
+ */
+int GameRecordView::get_result() const{
+    return int((m_header.flags >> 3) & 3) - 1;
+}
+
+/**
+ * @brief GameRecordView::get_player    : player of the move at ply
+ * @param ply                           : index of the move
+ * @return
+ */
+int GameRecordView::get_player(int ply) const{
+    return (ply & 1)? 3 - get_start() : get_start();
+}
+
+/**
+ * @brief GameRecordView::get_move  : column of the move at ply
+ * @param ply                       : index of the move, < get_plies()
+ * @return
+ */
+int GameRecordView::get_move(int ply) const{
+    const unsigned char *moves = m_data + sizeof(Header);
+    int bit = ply * BITS_PER_MOVE;
+    unsigned bits = moves[bit >> 3];
+    if(std::size_t(bit >> 3) + 1 < packed_moves_size(m_header.plies)){
+        bits |= unsigned(moves[(bit >> 3) + 1]) << 8;
+    }
+    return (bits >> (bit & 7)) & ((1 << BITS_PER_MOVE) - 1);
+}
+
+/**
+ * @brief GameRecordView::get_time_ms   : search time of the move at ply in ms, 0 for a human move
+ * @param ply                           : index of the move, < get_plies()
+ * @return
+ */
+unsigned GameRecordView::get_time_ms(int ply) const{
+    MoveInfo info;
+    std::memcpy(&info, m_data + sizeof(Header) + packed_moves_size(m_header.plies) + ply * sizeof(MoveInfo), sizeof(info));
+    return info.time_ms;
+}
+
+/**
+ * @brief GameRecordView::get_score : score of the move at ply for its player, 0 for a human move
+ * @param ply                       : index of the move, < get_plies()
+ * @return
+ */
+int GameRecordView::get_score(int ply) const{
+    MoveInfo info;
+    std::memcpy(&info, m_data + sizeof(Header) + packed_moves_size(m_header.plies) + ply * sizeof(MoveInfo), sizeof(info));
+    return info.score;
+}
+
+/**
+ * @brief GameRecordView::replay    : board after the first ply moves, stops at an invalid move
+ * @param ply                       : number of moves to play, clamped to get_plies()
+ * @return
+ */
+Board GameRecordView::replay(int ply) const{
+    Board board;
+    ply = std::min(ply, get_plies());
+    for(int i = 0; i < ply; ++i){
+        int col = get_move(i);
+        if(col >= Board::WIDTH || board.get_height(col) >= Board::HEIGHT){
+            break;
+        }
+        board.drop(col, get_player(i));
+    }
+    return board;
+}
+
+/**
+ * @brief GameRecordReader::iterator::iterator  : iterator at the record at pos, end if it is incomplete
+ * @param pos                                   : first byte of the record
+ * @param end                                   : end of the mapped records
+ */
+GameRecordReader::iterator::iterator(const unsigned char *pos, const unsigned char *end):
+    m_pos(valid_record(pos, end)? pos : end),
+    m_end(end)
+{}
+
+GameRecordView GameRecordReader::iterator::operator*() const{
+    return GameRecordView(m_pos);
+}
+
+GameRecordReader::iterator &GameRecordReader::iterator::operator++(){
+    m_pos += GameRecordView(m_pos).size();
+    if(!valid_record(m_pos, m_end)){
+        m_pos = m_end;
+    }
+    return *this;
+}
+
+bool GameRecordReader::iterator::operator!=(const iterator &other) const{
+    return m_pos != other.m_pos;
+}
+
+const unsigned char *GameRecordReader::iterator::position() const{
+    return m_pos;
+}
+
+/**
+ * @brief GameRecordReader::open    : maps a file of game records, only the file header is read
+ * @param path                      : record file
+ * @return                          : true if the file is a game record file
+ */
+bool GameRecordReader::open(const std::string &path){
+    m_valid = false;
+    if(!m_file.open(path) || m_file.size() < sizeof(FileHeader)){
+        m_file.close();
+        return false;
+    }
+    FileHeader header;
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    if(!valid_header(header)){
+        m_file.close();
+        return false;
+    }
+    m_valid = true;
+    return true;
+}
+
+/**
+ * @brief GameRecordReader::close   : unmaps the file
+ */
+void GameRecordReader::close(){
+    m_file.close();
+    m_valid = false;
+}
+
+/**
+ * @brief GameRecordReader::is_open : true if a record file is mapped
+ * @return
+ */
+bool GameRecordReader::is_open() const{
+    return m_valid;
+}
+
+/**
+ * @brief GameRecordReader::begin   : first record
+ * @return
+ */
+GameRecordReader::iterator GameRecordReader::begin() const{
+    if(!m_valid){
+        return iterator(nullptr, nullptr);
+    }
+    return iterator(m_file.data() + sizeof(FileHeader), m_file.data() + m_file.size());
+}
+
+/**
+ * @brief GameRecordReader::end : behind the last complete record
+ * @return
+ */
+GameRecordReader::iterator GameRecordReader::end() const{
+    if(!m_valid){
+        return iterator(nullptr, nullptr);
+    }
+    return iterator(m_file.data() + m_file.size(), m_file.data() + m_file.size());
+}
+
+/**
+ * @brief GameRecordReader::valid_size  : bytes of the file up to the end of the last complete record
+ * @return
+ */
+std::size_t GameRecordReader::valid_size() const{
+    if(!m_valid){
+        return 0;
+    }
+    std::size_t size = sizeof(FileHeader);
+    for(auto it = begin(); it != end(); ++it){
+        size += (*it).size();
+    }
+    return size;
+}
+
+/**
+ * @brief GameRecordReader::valid_header    : true if header is the one of a game record file of this version
+ * @param header                            : header read from a file
+ * @return
+ */
+bool GameRecordReader::valid_header(const FileHeader &header){
+    return std::memcmp(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) == 0 && header.version == RECORD_VERSION;
+}
+
+/**
+ * @brief GameRecordReader::make_header : header of a new game record file
+ * @return
+ */
+GameRecordReader::FileHeader GameRecordReader::make_header(){
+    FileHeader header;
+    std::memcpy(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+    header.version = RECORD_VERSION;
+    header.reserved = 0;
+    return header;
+}
+
+/**
+ * @brief GameRecordWriter::open    : opens a record file for appending, creates it if it does not exist
+ *                                    an incomplete record at the end (an interrupted append) is cut off
+ * @param path                      : record file
+ * @return                          : false if the file can't be written or is not a game record file
+ */
+bool GameRecordWriter::open(const std::string &path){
+    close();
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(path, error);
+    if(error){//does not exist yet
+        size = 0;
+    }
+    if(size > 0){
+        GameRecordReader reader;
+        if(!reader.open(path)){
+            return false;
+        }
+        std::size_t valid = reader.valid_size();
+        reader.close();
+        if(valid < size){
+            std::filesystem::resize_file(path, valid, error);
+            if(error){
+                return false;
+            }
+        }
+    }
+
+    m_out.open(path, std::ios::binary | std::ios::app);
+    if(size == 0){
+        GameRecordReader::FileHeader header = GameRecordReader::make_header();
+        m_out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        m_out.flush();
+    }
+    return m_out.good();
+}
+
+/**
+ * @brief GameRecordWriter::close   : closes the file
+ */
+void GameRecordWriter::close(){
+    if(m_out.is_open()){
+        m_out.close();
+    }
+    m_out.clear();
+}
+
+/**
+ * @brief GameRecordWriter::is_open : true if a file is open for appending
+ * @return
+ */
+bool GameRecordWriter::is_open() const{
+    return m_out.is_open();
+}
+
+/**
+ * @brief GameRecordWriter::append  : appends record to the file and flushes it
+ * @param record                    : game, at most WIDTH * HEIGHT moves, times and scores are saturated
+ * @return                          : true if it was written
+ */
+bool GameRecordWriter::append(const GameRecord &record){
+    int plies = int(record.moves.size());
+    if(!m_out.is_open() || plies > Board::WIDTH * Board::HEIGHT){
+        return false;
+    }
+
+    std::vector<unsigned char> bytes(GameRecordView::record_size(plies), 0);
+    GameRecordView::Header header;
+    header.size = uint16_t(bytes.size());
+    header.plies = uint8_t(plies);
+    header.flags = uint8_t((record.ai[0]? 1 : 0) | (record.ai[1]? 2 : 0) | ((record.start == 2)? 4 : 0)
+            | ((record.result + 1) << 3));
+    for(int i = 0; i < 2; ++i){
+        header.depth[i] = uint8_t(std::min(record.depth[i], 255));
+        header.budget_ms[i] = uint16_t(std::min(record.budget_ms[i], 65535u));
+    }
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    unsigned char *moves = bytes.data() + sizeof(header);
+    for(int i = 0; i < plies; ++i){
+        int bit = i * BITS_PER_MOVE;
+        unsigned col = unsigned(record.moves[i]);
+        moves[bit >> 3] |= uint8_t(col << (bit & 7));
+        if((bit & 7) + BITS_PER_MOVE > 8){
+            moves[(bit >> 3) + 1] |= uint8_t(col >> (8 - (bit & 7)));
+        }
+    }
+
+    unsigned char *infos = moves + packed_moves_size(plies);
+    for(int i = 0; i < plies; ++i){
+        GameRecordView::MoveInfo info;
+        info.time_ms = uint16_t(std::min(record.time_ms[i], 65535u));
+        info.score = int16_t(std::max(-32768, std::min(record.scores[i], 32767)));
+        std::memcpy(infos + i * sizeof(info), &info, sizeof(info));
+    }
+
+    m_out.write(reinterpret_cast<const char *>(bytes.data()), std::streamsize(bytes.size()));
+    m_out.flush();
+    return m_out.good();
+}
@@ -0,0 +1,134 @@
+#ifndef GAME_RECORD_H
+#define GAME_RECORD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "mapped_file.h"
+
+/**
+ * @brief The GameRecord struct is a finished or aborted game as Game collects it, written by GameRecordWriter
+ */
+struct GameRecord {
+    static constexpr int UNFINISHED = -1;
+
+    bool ai[2] = {false, false};
+    int depth[2] = {0, 0};
+    unsigned budget_ms[2] = {0, 0};     //0 if the ai searched to its depth
+    int start = 1;                      //player of the first move
+    int result = UNFINISHED;            //winner, 0 for a draw
+    std::vector<int> moves;
+    std::vector<unsigned> time_ms;      //per move, 0 for human moves
+    std::vector<int> scores;            //per move, 0 for human moves
+
+    void add_move(int col, unsigned move_time_ms, int score);
+};
+
+/**
+ * @brief The GameRecordView class reads one record in place, e.g. in a memory mapped file, without copying it
+ *
+ * Record layout (little endian): Header, the moves packed with 3 bits each, ply 0 in the lowest bits of the first
+ * byte, then a MoveInfo per ply. Records are not aligned, fields are read with memcpy.
+ */
+class GameRecordView
+{
+public:
+    struct Header {
+        uint16_t size;          //bytes of the whole record
+        uint8_t plies;
+        uint8_t flags;          //bit 0/1: player 1/2 is an ai, bit 2: player 2 starts, bits 3-4: result + 1
+        uint8_t depth[2];
+        uint16_t budget_ms[2];
+    };
+
+    struct MoveInfo {
+        uint16_t time_ms;       //saturated
+        int16_t score;
+    };
+
+    explicit GameRecordView(const unsigned char *data = nullptr);
+
+    std::size_t size() const;
+    int get_plies() const;
+    bool is_ai(int player) const;
+    int get_depth(int player) const;
+    unsigned get_budget_ms(int player) const;
+    int get_start() const;
+    int get_result() const;
+    int get_player(int ply) const;
+    int get_move(int ply) const;
+    unsigned get_time_ms(int ply) const;
+    int get_score(int ply) const;
+    Board replay(int ply) const;
+
+    static std::size_t record_size(int plies);
+
+private:
+    const unsigned char *m_data;
+    Header m_header;
+};
+
+/**
+ * @brief The GameRecordReader class maps a file of game records and iterates over them as views, no record is copied
+ *
+ * File layout: FileHeader, then the records back to back. A record which runs over the end of the file (an
+ * interrupted append) ends the iteration.
+ */
+class GameRecordReader
+{
+public:
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    class iterator
+    {
+    public:
+        iterator(const unsigned char *pos, const unsigned char *end);
+        GameRecordView operator*() const;
+        iterator &operator++();
+        bool operator!=(const iterator &other) const;
+        const unsigned char *position() const;
+
+    private:
+        const unsigned char *m_pos;
+        const unsigned char *m_end;
+    };
+
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+    iterator begin() const;
+    iterator end() const;
+    std::size_t valid_size() const;
+
+    static bool valid_header(const FileHeader &header);
+    static FileHeader make_header();
+
+private:
+    MappedFile m_file;
+    bool m_valid = false;
+};
+
+/**
+ * @brief The GameRecordWriter class appends game records to a file, one record per call, flushed right away
+ */
+class GameRecordWriter
+{
+public:
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+    bool append(const GameRecord &record);
+
+private:
+    std::ofstream m_out;
+};
+
+#endif // GAME_RECORD_H
@@ -0,0 +1,77 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <cstdint>
+#include <vector>
+
+//hot path counters of the search, SEARCH_STAT(statements) compiles to nothing without CONNECT4_SEARCH_STATS
+#ifdef CONNECT4_SEARCH_STATS
+#define SEARCH_STAT(...) __VA_ARGS__
+#else
+#define SEARCH_STAT(...)
+#endif
+
+/**
+ * @brief The SearchCounters struct holds the counters of one search thread, empty if they are compiled out
+ */
+struct SearchCounters {
+#ifdef CONNECT4_SEARCH_STATS
+    uint64_t leaf_evals = 0;
+    uint64_t beta_cutoffs = 0;
+    uint64_t first_move_cutoffs = 0;
+    uint64_t tt_cutoffs = 0;
+    uint64_t tt_hits = 0;
+    uint64_t tt_misses = 0;
+    uint64_t tt_stores = 0;
+    uint64_t tt_overwrites = 0;
+    int max_ply = 0;
+#endif
+};
+
+/**
+ * @brief The SearchStats struct describes one search: node counts per thread and, if compiled in, the hot path counters
+ */
+struct SearchStats {
+#ifdef CONNECT4_SEARCH_STATS
+    static constexpr bool COUNTERS = true;
+#else
+    static constexpr bool COUNTERS = false;
+#endif
+
+    uint64_t nodes = 0;
+    int depth = 0;                      //deepest finished iteration
+    long long time_us = 0;
+    bool book = false;                  //answered by the opening book, no search
+    bool pondered = false;              //searched during the opponent's turn, the time is only the lookup
+    std::vector<uint64_t> thread_nodes; //nodes per search thread, the main thread first
+
+    //only counted if COUNTERS is true, summed over all threads
+    uint64_t leaf_evals = 0;
+    uint64_t beta_cutoffs = 0;
+    uint64_t first_move_cutoffs = 0;    //cutoffs by the first searched move, a measure of the move ordering
+    uint64_t tt_cutoffs = 0;            //nodes decided by the transposition table
+    uint64_t tt_hits = 0;               //probes of the transposition table which found the position
+    uint64_t tt_misses = 0;
+    uint64_t tt_stores = 0;
+    uint64_t tt_overwrites = 0;         //stores which replaced another position
+    int max_ply = 0;                    //deepest node reached by any thread
+
+    double first_move_cutoff_rate() const{
+        return beta_cutoffs? double(first_move_cutoffs) / double(beta_cutoffs) : 0.0;
+    }
+};
+
+/**
+ * @brief The SearchProgress struct is an intermediate result of a running search, published while it improves
+ */
+struct SearchProgress {
+    int move = -1;              //best move so far
+    int score = 0;
+    int depth = 0;              //iteration the move is from
+    bool complete = false;      //the iteration is finished, otherwise only part of the root moves are searched
+    std::vector<int> pv;        //principal variation from the transposition table, starting with move
+    uint64_t nodes = 0;         //nodes of the main search thread
+    long long time_us = 0;      //since the start of the search
+};
+
+#endif // SEARCH_STATS_H
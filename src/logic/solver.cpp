@@ -0,0 +1,339 @@
+#include "solver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr int WIDTH = Board::WIDTH;
+constexpr int HEIGHT = Board::HEIGHT;
+constexpr int CELLS = WIDTH * HEIGHT;
+constexpr int COL_BITS = HEIGHT + 1;
+constexpr int MIN_SCORE = -CELLS / 2 + 3;
+constexpr int MAX_SCORE = (CELLS + 1) / 2 - 3;
+
+constexpr uint64_t make_bottom_mask(){
+    uint64_t mask = 0;
+    for(int col = 0; col < WIDTH; ++col){
+        mask |= uint64_t(1) << (col * COL_BITS);
+    }
+    return mask;
+}
+
+constexpr uint64_t BOTTOM_MASK = make_bottom_mask();
+constexpr uint64_t BOARD_MASK = BOTTOM_MASK * ((uint64_t(1) << HEIGHT) - 1);
+
+constexpr uint64_t bottom_cell(int col){
+    return uint64_t(1) << (col * COL_BITS);
+}
+
+constexpr uint64_t column_mask(int col){
+    return ((uint64_t(1) << HEIGHT) - 1) << (col * COL_BITS);
+}
+
+//left-right mirror of a key, a position and its mirror have the same score
+inline uint64_t mirror_key(uint64_t key){
+    uint64_t mirrored = 0;
+    for(int col = 0; col < WIDTH; ++col){
+        mirrored |= ((key >> (col * COL_BITS)) & ((uint64_t(1) << COL_BITS) - 1)) << ((WIDTH - 1 - col) * COL_BITS);
+    }
+    return mirrored;
+}
+
+//columns from the center to the sides
+constexpr int column_order(int i){
+    return WIDTH / 2 + (1 - 2 * (i % 2)) * (i + 1) / 2;
+}
+
+inline int popcount(uint64_t x){
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(x));
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+//empty cells which would complete 4 in a row for position
+uint64_t winning_cells(uint64_t position, uint64_t mask){
+    //vertical
+    uint64_t r = (position << 1) & (position << 2) & (position << 3);
+
+    //horizontal and both diagonals
+    for(int dir : {COL_BITS, HEIGHT, HEIGHT + 2}){
+        uint64_t p = (position << dir) & (position << (2 * dir));
+        r |= p & (position << (3 * dir));
+        r |= p & (position >> dir);
+        p = (position >> dir) & (position >> (2 * dir));
+        r |= p & (position << dir);
+        r |= p & (position >> (3 * dir));
+    }
+    return r & (BOARD_MASK ^ mask);
+}
+
+inline uint64_t possible(uint64_t mask){
+    return (mask + BOTTOM_MASK) & BOARD_MASK;
+}
+
+//moves which don't give the opponent an immediate win, 0 if every move looses
+uint64_t non_losing_moves(uint64_t current, uint64_t mask){
+    uint64_t possible_mask = possible(mask);
+    uint64_t opponent_win = winning_cells(current ^ mask, mask);
+    uint64_t forced_moves = possible_mask & opponent_win;
+    if(forced_moves){
+        if(forced_moves & (forced_moves - 1)){//two threats at once
+            return 0;
+        }
+        possible_mask = forced_moves;
+    }
+    return possible_mask & ~(opponent_win >> 1);
+}
+
+bool is_prime(std::size_t n){
+    if(n < 2){
+        return false;
+    }
+    for(std::size_t d = 2; d * d <= n; ++d){
+        if(n % d == 0){
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+/**
+ * @brief Solver::Solver    : allocates the transposition table
+ * @param table_size_mb     : size of the table in megabytes, at least 1
+ */
+Solver::Solver(std::size_t table_size_mb):
+    m_nodes(0)
+{
+    //a prime number of slots, so the slot and the lower 32 bits identify the key
+    std::size_t slots = std::max<std::size_t>(table_size_mb, 1) * 1024 * 1024 / (sizeof(uint32_t) + sizeof(uint8_t));
+    while(!is_prime(slots)){
+        --slots;
+    }
+    m_keys.resize(slots);
+    m_values.resize(slots);
+    reset();
+}
+
+/**
+ * @brief Solver::~Solver   : empty destructor
+ */
+Solver::~Solver()
+{}
+
+/**
+ * @brief Solver::reset : empties the transposition table
+ */
+void Solver::reset(){
+    std::fill(m_keys.begin(), m_keys.end(), 0);
+    std::fill(m_values.begin(), m_values.end(), 0);
+}
+
+/**
+ * @brief Solver::put   : stores a bound of key
+ */
+void Solver::put(uint64_t key, uint8_t value){
+    std::size_t slot = std::size_t(key % m_keys.size());
+    m_keys[slot] = uint32_t(key);
+    m_values[slot] = value;
+}
+
+/**
+ * @brief Solver::get   : returns the stored bound of key, 0 if none
+ */
+uint8_t Solver::get(uint64_t key) const{
+    std::size_t slot = std::size_t(key % m_keys.size());
+    return (m_keys[slot] == uint32_t(key))? m_values[slot] : 0;
+}
+
+/**
+ * @brief Solver::negamax   : null window capable negamax, the player to move must not be able to win immediately
+ * @param pos               : current position
+ * @param alpha             : lower bound of the window
+ * @param beta              : upper bound of the window
+ * @return                  : exact score inside the window, otherwise a bound on the right side of it
+ */
+int Solver::negamax(const Position &pos, int alpha, int beta){
+    ++m_nodes;
+
+    uint64_t next = non_losing_moves(pos.current, pos.mask);
+    if(next == 0){//opponent wins with the next move
+        return -(CELLS - pos.moves) / 2;
+    }
+    if(pos.moves >= CELLS - 2){//no one can win anymore
+        return 0;
+    }
+
+    int min = -(CELLS - 2 - pos.moves) / 2;
+    if(alpha < min){
+        alpha = min;
+        if(alpha >= beta){
+            return alpha;
+        }
+    }
+    int max = (CELLS - 1 - pos.moves) / 2;
+
+    //a position and its mirror share their bounds
+    uint64_t key = pos.current + pos.mask;
+    key = std::min(key, mirror_key(key));
+    int value = get(key);
+    if(value){
+        if(value > MAX_SCORE - MIN_SCORE + 1){//lower bound
+            min = value + 2 * MIN_SCORE - MAX_SCORE - 2;
+            if(alpha < min){
+                alpha = min;
+                if(alpha >= beta){
+                    return alpha;
+                }
+            }
+        }
+        else{//upper bound
+            max = value + MIN_SCORE - 1;
+        }
+    }
+    if(beta > max){
+        beta = max;
+        if(alpha >= beta){
+            return beta;
+        }
+    }
+
+    //order the moves by the number of threats they create, center first on ties
+    uint64_t moves[WIDTH];
+    int scores[WIDTH];
+    int n_moves = 0;
+    for(int i = WIDTH - 1; i >= 0; --i){
+        uint64_t move = next & column_mask(column_order(i));
+        if(!move){
+            continue;
+        }
+        int score = popcount(winning_cells(pos.current | move, pos.mask));
+        int j = n_moves++;
+        for(; j > 0 && scores[j - 1] > score; --j){
+            moves[j] = moves[j - 1];
+            scores[j] = scores[j - 1];
+        }
+        moves[j] = move;
+        scores[j] = score;
+    }
+
+    for(int i = n_moves - 1; i >= 0; --i){
+        Position child = {pos.current ^ pos.mask, pos.mask | moves[i], pos.moves + 1};
+        int score = -negamax(child, -beta, -alpha);
+        if(score >= beta){
+            put(key, uint8_t(score + MAX_SCORE - 2 * MIN_SCORE + 2));
+            return score;
+        }
+        if(score > alpha){
+            alpha = score;
+        }
+    }
+    put(key, uint8_t(alpha - MIN_SCORE + 1));
+    return alpha;
+}
+
+/**
+ * @brief Solver::solve_score   : exact score of pos by bisection with null window searches
+ * @param pos                   : position, the player to move must not be able to win immediately
+ * @return
+ */
+int Solver::solve_score(Position pos){
+    int min = -(CELLS - pos.moves) / 2;
+    int max = (CELLS + 1 - pos.moves) / 2;
+    while(min < max){
+        int med = min + (max - min) / 2;
+        if(med <= 0 && min / 2 < med){
+            med = min / 2;
+        }
+        else if(med >= 0 && max / 2 > med){
+            med = max / 2;
+        }
+        int r = negamax(pos, med, med + 1);
+        if(r <= med){
+            max = r;
+        }
+        else{
+            min = r;
+        }
+    }
+    return min;
+}
+
+/**
+ * @brief Solver::solve : solves the position for player to move, the game must not be over
+ * @param board         : current board
+ * @param player        : player to move
+ * @return              : exact result, best move, searched nodes and time
+ */
+Solver::Result Solver::solve(const Board &board, int player){
+    auto t_start = std::chrono::steady_clock::now();
+    m_nodes = 0;
+
+    Position pos = {board.get_stones(player), board.get_mask(), board.get_moves()};
+    Result result;
+    result.move = -1;
+
+    uint64_t wins = winning_cells(pos.current, pos.mask) & possible(pos.mask);
+    if(wins){
+        result.score = (CELLS + 1 - pos.moves) / 2;
+        for(int i = 0; i < WIDTH && result.move < 0; ++i){
+            if(wins & column_mask(column_order(i))){
+                result.move = column_order(i);
+            }
+        }
+    }
+    else{
+        result.score = solve_score(pos);
+
+        //best move: the first move whose child proves the score, the table makes these searches cheap
+        uint64_t playable = possible(pos.mask);
+        for(int i = 0; i < WIDTH && result.move < 0; ++i){
+            int col = column_order(i);
+            uint64_t move = playable & column_mask(col);
+            if(!move){
+                continue;
+            }
+            Position child = {pos.current ^ pos.mask, pos.mask | move, pos.moves + 1};
+            int score;
+            if(child.moves == CELLS){
+                score = 0;
+            }
+            else if(winning_cells(child.current, child.mask) & possible(child.mask)){
+                score = -(CELLS + 1 - child.moves) / 2;
+            }
+            else{
+                score = -negamax(child, -result.score, -result.score + 1);
+            }
+            if(score >= result.score){
+                result.move = col;
+            }
+        }
+    }
+
+    //stones on the board after the winning one, its parity tells whose stone it is
+    result.outcome = (result.score > 0) - (result.score < 0);
+    if(result.outcome == 0){
+        result.distance = CELLS - pos.moves;
+    }
+    else{
+        int winner_parity = (result.outcome > 0)? (pos.moves + 1) % 2 : pos.moves % 2;
+        int final_moves = CELLS + 2 - 2 * std::abs(result.score);
+        if(final_moves % 2 != winner_parity){
+            --final_moves;
+        }
+        result.distance = final_moves - pos.moves;
+    }
+
+    result.nodes = m_nodes;
+    result.time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start).count();
+    return result;
+}
@@ -0,0 +1,54 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "board.h"
+
+/**
+ * @brief The Solver class computes the exact game-theoretic value of a position
+ *
+ * Negamax with alpha-beta on null windows, the value is found by bisection on the score bound. Scores follow
+ * the usual convention: a win with the k-th last own stone of the board scores k, so positive is a win for the
+ * player to move, negative a loss, 0 a draw, and faster wins score higher.
+ */
+class Solver
+{
+public:
+    struct Result {
+        int score;          //exact score, see above
+        int outcome;        //1 win, 0 draw, -1 loss for the player to move
+        int distance;       //plies until the game ends with perfect play, including the last move
+        int move;           //best move
+        uint64_t nodes;
+        long long time_us;
+    };
+
+    explicit Solver(std::size_t table_size_mb = 64);
+    ~Solver();
+
+    Result solve(const Board &board, int player);
+    void reset();
+
+private:
+    //position of the player to move as bitboards, in the layout of Board
+    struct Position {
+        uint64_t current;
+        uint64_t mask;
+        int moves;
+    };
+
+    std::vector<uint32_t> m_keys;
+    std::vector<uint8_t> m_values;
+    uint64_t m_nodes;
+
+    int solve_score(Position pos);
+    int negamax(const Position &pos, int alpha, int beta);
+
+    void put(uint64_t key, uint8_t value);
+    uint8_t get(uint64_t key) const;
+};
+
+#endif // SOLVER_H
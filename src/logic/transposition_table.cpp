@@ -0,0 +1,141 @@
+#include "transposition_table.h"
+
+/**
+ * @brief TranspositionTable::TranspositionTable    : allocates the table, rounded down to a power of two buckets
+ * @param size_mb                                   : size of the table in megabytes
+ */
+TranspositionTable::TranspositionTable(std::size_t size_mb){
+    std::size_t buckets = 1;
+    while(buckets * 2 * sizeof(Bucket) <= size_mb * 1024 * 1024){
+        buckets *= 2;
+    }
+    m_buckets.reset(new Bucket[buckets]);
+    m_bucket_mask = buckets - 1;
+    clear();
+}
+
+/**
+ * @brief TranspositionTable::~TranspositionTable   : empty destructor
+ */
+TranspositionTable::~TranspositionTable()
+{}
+
+/**
+ * @brief TranspositionTable::bucket    : returns the bucket of key, keys are mixed since they are very regular
+ * @param key                           : position key
+ * @return
+ */
+TranspositionTable::Bucket &TranspositionTable::bucket(uint64_t key){
+    return m_buckets[((key * 0x9E3779B97F4A7C15ULL) >> 20) & m_bucket_mask];
+}
+
+/**
+ * @brief TranspositionTable::pack  : packs an entry into 64 bits, score 16 bit, depth 8 bit, bound 2 bit, move 4 bit
+ * @return
+ */
+uint64_t TranspositionTable::pack(int score, int depth, Bound bound, int move){
+    return uint64_t(uint16_t(int16_t(score)))
+            | (uint64_t(uint8_t(depth)) << 16)
+            | (uint64_t(bound) << 24)
+            | (uint64_t(move + 1) << 26);
+}
+
+/**
+ * @brief TranspositionTable::unpack    : inverse of pack
+ * @param data                          : packed entry
+ * @return
+ */
+TranspositionTable::Entry TranspositionTable::unpack(uint64_t data){
+    Entry entry;
+    entry.score = int16_t(uint16_t(data & 0xFFFF));
+    entry.depth = int((data >> 16) & 0xFF);
+    entry.bound = Bound((data >> 24) & 0x3);
+    entry.move = int((data >> 26) & 0xF) - 1;
+    return entry;
+}
+
+/**
+ * @brief TranspositionTable::probe : looks up key
+ * @param key                       : position key
+ * @param entry                     : filled with the stored values on a hit
+ * @return                          : true on a hit
+ */
+bool TranspositionTable::probe(uint64_t key, Entry &entry){
+    Bucket &b = bucket(key);
+    for(auto &slot : b.entries){
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if((check ^ data) == key && data != 0){
+            entry = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief TranspositionTable::store : stores a search result, replaces the same key, an empty or the shallowest slot
+ * @param key                       : position key
+ * @param score                     : score of the search
+ * @param depth                     : remaining depth of the search
+ * @param bound                     : whether score is exact or a lower/upper bound
+ * @param move                      : best move found, -1 if none
+ * @return                          : true if the entry of another position was overwritten
+ */
+bool TranspositionTable::store(uint64_t key, int score, int depth, Bound bound, int move){
+    Bucket &b = bucket(key);
+    Slot *target = nullptr;
+    int target_depth = 256;
+    for(auto &slot : b.entries){
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if(data == 0 || (check ^ data) == key){
+            target = &slot;
+            target_depth = -1;
+            break;
+        }
+        int depth_in_slot = int((data >> 16) & 0xFF);
+        if(depth_in_slot < target_depth){
+            target = &slot;
+            target_depth = depth_in_slot;
+        }
+    }
+    uint64_t data = pack(score, depth, bound, move);
+    target->data.store(data, std::memory_order_relaxed);
+    target->check.store(key ^ data, std::memory_order_relaxed);
+    return target_depth >= 0;
+}
+
+/**
+ * @brief TranspositionTable::clear : empties all slots, must not run concurrently with a search
+ */
+void TranspositionTable::clear(){
+    for(uint64_t i = 0; i <= m_bucket_mask; ++i){
+        for(auto &slot : m_buckets[i].entries){
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief TranspositionTable::get_size_mb   : returns the allocated size in megabytes
+ * @return
+ */
+std::size_t TranspositionTable::get_size_mb() const{
+    return (m_bucket_mask + 1) * sizeof(Bucket) / (1024 * 1024);
+}
+
+/**
+ * @brief TranspositionTable::count_entries : number of used slots, scans the whole table
+ * @return
+ */
+std::size_t TranspositionTable::count_entries() const{
+    std::size_t entries = 0;
+    for(uint64_t i = 0; i <= m_bucket_mask; ++i){
+        for(const auto &slot : m_buckets[i].entries){
+            entries += slot.data.load(std::memory_order_relaxed) != 0;
+        }
+    }
+    return entries;
+}
@@ -0,0 +1,59 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief The TranspositionTable class caches search results per position, shared by all search threads
+ *
+ * Entries are 16 bytes and grouped into 64 byte buckets, so a probe touches a single cache line.
+ * Every entry stores the key xor'ed with its data, torn writes of concurrent threads are
+ * detected on probe and treated as a miss instead of needing a lock. The table keeps no counters,
+ * every search thread counts its own probes and stores, see SearchCounters.
+ */
+class TranspositionTable
+{
+public:
+    enum Bound : uint8_t {NONE = 0, EXACT = 1, LOWER = 2, UPPER = 3};
+
+    struct Entry {
+        int score;
+        int depth;
+        Bound bound;
+        int move;   //-1 if no best move is known
+    };
+
+    explicit TranspositionTable(std::size_t size_mb);
+    ~TranspositionTable();
+
+    bool probe(uint64_t key, Entry &entry);
+    bool store(uint64_t key, int score, int depth, Bound bound, int move);
+    void clear();
+
+    std::size_t get_size_mb() const;
+    std::size_t count_entries() const;
+
+private:
+    static constexpr int BUCKET_ENTRIES = 4;
+
+    struct Slot {
+        std::atomic<uint64_t> check;    //key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        Slot entries[BUCKET_ENTRIES];
+    };
+
+    std::unique_ptr<Bucket[]> m_buckets;
+    uint64_t m_bucket_mask;
+
+    Bucket &bucket(uint64_t key);
+    static uint64_t pack(int score, int depth, Bound bound, int move);
+    static Entry unpack(uint64_t data);
+};
+
+#endif // TRANSPOSITION_TABLE_H
@@ -0,0 +1,140 @@
+/**
+* @brief    Generates the opening book: searches all positions up to a number of plies and writes their best moves
+* @file     book_generator.cpp
+*
+* usage: connect4_book <output> [plies] [depth] [threads] [--eval threats|positional]
+*
+* The book is searched with the threat evaluation by default, the one the GUI plays with. Ais of another evaluation
+* don't use it.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "ai.h"
+#include "book.h"
+
+namespace {
+
+struct Job {
+    Board board;
+    int player;
+};
+
+//all positions with up to plies stones which are not decided yet, one per mirror pair
+std::vector<Job> enumerate_positions(int plies){
+    std::vector<Job> jobs;
+    std::vector<Board> level(1);
+    int player = 1;
+    for(int ply = 0; ply <= plies && !level.empty(); ++ply){
+        std::vector<Board> next;
+        std::unordered_set<uint64_t> seen;
+        for(const auto &board : level){
+            jobs.push_back(Job{board, player});
+            if(ply == plies){
+                continue;
+            }
+            for(int col : board.possible_drops()){
+                Board child = board;
+                child.drop(col, player);
+                if(child.is_winner(player) || child.is_full()){
+                    continue;
+                }
+                bool mirrored;
+                if(seen.insert(Book::canonical_key(child, 3 - player, mirrored)).second){
+                    next.push_back(child);
+                }
+            }
+        }
+        std::printf("ply %d: %zu positions\n", ply, level.size());
+        level.swap(next);
+        player = 3 - player;
+    }
+    return jobs;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    //--eval may stand anywhere, the other arguments are positional
+    Ai::Evaluation evaluation = Ai::THREATS;
+    std::vector<std::string> args;
+    bool valid = true;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg != "--eval"){
+            args.push_back(arg);
+            continue;
+        }
+        std::string value = (i + 1 < argc)? argv[++i] : "";
+        if(value == "threats"){
+            evaluation = Ai::THREATS;
+        }
+        else if(value == "positional"){
+            evaluation = Ai::POSITIONAL;
+        }
+        else{
+            valid = false;
+        }
+    }
+    if(args.empty() || !valid){
+        std::printf("usage: %s <output> [plies] [depth] [threads] [--eval threats|positional]\n", argv[0]);
+        return 1;
+    }
+    std::string output = args[0];
+    int plies = (args.size() > 1)? std::atoi(args[1].c_str()) : 8;
+    int depth = (args.size() > 2)? std::atoi(args[2].c_str()) : 12;
+    int threads = (args.size() > 3)? std::atoi(args[3].c_str()) : 0;
+    if(threads <= 0){
+        threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    std::vector<Job> jobs = enumerate_positions(plies);
+    std::vector<Book::Entry> entries(jobs.size());
+    std::atomic<std::size_t> next(0);
+    auto t_start = std::chrono::steady_clock::now();
+
+    //one single threaded search per worker, positions are handed out one by one. Every position is searched by a new
+    //game of the ai, so its entry does not depend on the positions the worker searched before
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&]{
+            Ai ai(depth, 1);
+            ai.set_threads(1);
+            ai.set_evaluation(evaluation);
+            for(std::size_t i = next++; i < jobs.size(); i = next++){
+                const Job &job = jobs[i];
+                ai.new_game(job.player);
+                std::pair<int, int> result = ai.get_move(job.board);
+
+                bool mirrored;
+                Book::Entry &entry = entries[i];
+                entry.key = Book::canonical_key(job.board, job.player, mirrored);
+                entry.move = uint8_t(mirrored? Board::WIDTH - 1 - result.first : result.first);
+                entry.score = int16_t(result.second);
+                entry.depth = uint8_t(depth);
+                entry.reserved = 0;
+            }
+        });
+    }
+    for(auto &worker : workers){
+        worker.join();
+    }
+
+    auto t_end = std::chrono::steady_clock::now();
+    if(!Book::write(output, entries, plies, evaluation)){
+        std::printf("could not write %s\n", output.c_str());
+        return 1;
+    }
+    std::printf("%zu positions at depth %d (%s evaluation) in %lld s written to %s\n", entries.size(), depth,
+                (evaluation == Ai::THREATS)? "threat" : "positional",
+                (long long)std::chrono::duration_cast<std::chrono::seconds>(t_end - t_start).count(), output.c_str());
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+* @brief    Generator of solved positions: samples positions from random and ai self-play games, solves them
+*           exactly on all cores and appends them to a dataset file (see Dataset)
+* @file     dataset_generator.cpp
+*
+* usage: connect4_dataset <dataset> [positions=10000] [threads=0] [min_ply=12] [max_ply=36] [depth=6] [seed=1] [table_mb=32]
+*
+* Position i is sampled from its own seed, even ones from random games, odd ones from self-play of an ai of
+* the given depth which plays a random move with probability 1/8. The positions are written in sample order,
+* so running the same command again resumes an interrupted run and extends the dataset to the given size.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai.h"
+#include "dataset.h"
+#include "solver.h"
+
+namespace {
+
+struct Settings {
+    uint32_t seed;
+    int min_ply;
+    int max_ply;
+    int depth;
+};
+
+//one move of a sampled game, random or by the self-play ai of player
+int sample_move(const Board &board, int player, Dataset::Source source, std::unique_ptr<Ai> ais[2], std::mt19937 &rng){
+    std::vector<int> drops = board.possible_drops();
+    if(source == Dataset::RANDOM || board.get_moves() < 2 || rng() % 8 == 0){
+        return drops[rng() % drops.size()];
+    }
+    return ais[player - 1]->get_move(board).first;
+}
+
+/**
+ * @brief sample_position   : position index of the dataset, the same for a seed on every run
+ * @param settings          : seed, ply range and self-play depth
+ * @param index             : index of the position
+ * @param board             : sampled position, the game is not over
+ * @param player            : player to move
+ * @param source            : random or self-play game
+ */
+void sample_position(const Settings &settings, std::size_t index, Board &board, int &player, Dataset::Source &source){
+    std::seed_seq seq{settings.seed, uint32_t(index), uint32_t(uint64_t(index) >> 32)};
+    std::mt19937 rng(seq);
+    source = (index % 2 == 0)? Dataset::RANDOM : Dataset::SELF_PLAY;
+    int ply = settings.min_ply + int(rng() % unsigned(settings.max_ply - settings.min_ply + 1));
+
+    std::unique_ptr<Ai> ais[2];
+    if(source == Dataset::SELF_PLAY){
+        for(int p = 1; p <= 2; ++p){
+            ais[p - 1].reset(new Ai(settings.depth, p, 1));
+            ais[p - 1]->set_threads(1);
+            ais[p - 1]->set_evaluation(Ai::THREATS);
+        }
+    }
+
+    //games which end before the ply are played again with the next random numbers
+    while(true){
+        board.reset();
+        player = 1;
+        bool over = false;
+        while(board.get_moves() < ply && !over){
+            board.drop(sample_move(board, player, source, ais, rng), player);
+            over = board.is_game_over(player);
+            player = 3 - player;
+        }
+        if(!over){
+            return;
+        }
+    }
+}
+
+/**
+ * @brief prepare_file  : checks an existing dataset against the settings and cuts off a partial last entry,
+ *                        or creates the file with its header
+ * @param path          : dataset file
+ * @param settings      : settings of this run
+ * @param count         : set to the number of entries already in the file
+ * @return              : false if the file belongs to other settings or can't be written
+ */
+bool prepare_file(const std::string &path, const Settings &settings, std::size_t &count){
+    Dataset::Header header = Dataset::make_header(settings.seed, settings.min_ply, settings.max_ply, settings.depth);
+    count = 0;
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(path, error);
+    if(error || size == 0){
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        return out.good();
+    }
+
+    Dataset dataset;
+    if(!dataset.open(path)){
+        return false;
+    }
+    const Dataset::Header &existing = dataset.get_header();
+    if(existing.seed != header.seed || existing.min_ply != header.min_ply || existing.max_ply != header.max_ply
+            || existing.depth != header.depth){
+        return false;
+    }
+    count = dataset.size();
+    dataset.close();
+    std::filesystem::resize_file(path, sizeof(Dataset::Header) + count * sizeof(Dataset::Entry), error);
+    return !error;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2){
+        std::printf("usage: %s <dataset> [positions=10000] [threads=0] [min_ply=12] [max_ply=36] [depth=6] [seed=1] [table_mb=32]\n", argv[0]);
+        return 1;
+    }
+    std::string path = argv[1];
+    std::size_t positions = (argc > 2)? std::size_t(std::atoll(argv[2])) : 10000;
+    int threads = (argc > 3)? std::atoi(argv[3]) : 0;
+    Settings settings;
+    settings.min_ply = (argc > 4)? std::atoi(argv[4]) : 12;
+    settings.max_ply = (argc > 5)? std::atoi(argv[5]) : 36;
+    settings.depth = (argc > 6)? std::atoi(argv[6]) : 6;
+    settings.seed = (argc > 7)? uint32_t(std::atoll(argv[7])) : 1;
+    std::size_t table_mb = (argc > 8)? std::size_t(std::atoi(argv[8])) : 32;
+    if(threads <= 0){
+        threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    if(settings.min_ply < 0 || settings.max_ply < settings.min_ply || settings.max_ply >= Board::WIDTH * Board::HEIGHT
+            || settings.depth < 1){
+        std::printf("invalid ply range or depth\n");
+        return 1;
+    }
+
+    std::size_t done;
+    if(!prepare_file(path, settings, done)){
+        std::printf("%s can't be written or belongs to other settings\n", path.c_str());
+        return 1;
+    }
+    if(done > 0){
+        std::printf("resuming: %zu positions done\n", done);
+    }
+    if(done >= positions){
+        return 0;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+
+    //workers solve positions in any order, they are written in sample order so a resumed run continues seamlessly
+    std::mutex mutex;
+    std::map<std::size_t, Dataset::Entry> pending;
+    std::size_t written = done;
+    uint64_t total_nodes = 0;
+    long long outcomes[3] = {0, 0, 0};
+    std::atomic<std::size_t> next(done);
+    auto t_start = std::chrono::steady_clock::now();
+    auto t_report = t_start;
+
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&]{
+            Solver solver(table_mb);
+            for(std::size_t i = next++; i < positions; i = next++){
+                Board board;
+                int player;
+                Dataset::Source source;
+                sample_position(settings, i, board, player, source);
+                Solver::Result result = solver.solve(board, player);
+
+                Dataset::Entry entry;
+                entry.key = board.player_key(player);
+                entry.score = int8_t(result.score);
+                entry.move = uint8_t(result.move);
+                entry.ply = uint8_t(board.get_moves());
+                entry.source = uint8_t(source);
+                entry.nodes = uint32_t(std::min<uint64_t>(result.nodes, UINT32_MAX));
+
+                std::lock_guard<std::mutex> guard(mutex);
+                pending[i] = entry;
+                total_nodes += result.nodes;
+                ++outcomes[result.outcome + 1];
+                while(!pending.empty() && pending.begin()->first == written){
+                    out.write(reinterpret_cast<const char *>(&pending.begin()->second), sizeof(Dataset::Entry));
+                    pending.erase(pending.begin());
+                    ++written;
+                }
+                out.flush();
+
+                auto now = std::chrono::steady_clock::now();
+                if(now - t_report >= std::chrono::seconds(10)){
+                    t_report = now;
+                    double hours = std::chrono::duration<double>(now - t_start).count() / 3600.0;
+                    std::printf("%zu / %zu positions, %.0f positions/hour\n", written, positions, double(written - done) / hours);
+                    std::fflush(stdout);
+                }
+            }
+        });
+    }
+    for(auto &worker : workers){
+        worker.join();
+    }
+
+    double seconds = std::max(1e-3, std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count());
+    std::size_t solved = written - done;
+    std::printf("%zu positions solved in %.1f s on %d threads: %.0f positions/hour, %.0f nodes per position\n", solved, seconds,
+                threads, double(solved) * 3600.0 / seconds, double(total_nodes) / double(std::max<std::size_t>(1, solved)));
+    std::printf("player to move wins %lld, draws %lld, looses %lld\n", outcomes[2], outcomes[1], outcomes[0]);
+    return out.good()? 0 : 1;
+}
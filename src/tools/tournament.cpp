@@ -0,0 +1,366 @@
+/**
+* @brief    Self-play tournament of two ai settings: plays many games concurrently, streams them to a csv
+*           and reports win/draw/loss, Elo difference and the time per move
+* @file     tournament.cpp
+*
+* usage: connect4_tournament <results.csv> <ai_a> <ai_b> [games=1000] [threads=0] [random_plies=4] [seed=1]
+*
+* An ai is given as depth[:eval[:time_ms]], eval is positional (default) or threats, time_ms > 0 searches
+* with a time budget per move instead of the fixed depth, e.g. 8:threats or 20:positional:50.
+* Game 2k and 2k+1 start from the same random opening with swapped colors. Every finished game is
+* appended to the csv at once, an existing csv of the same settings is resumed: its games are kept
+* and only the missing ones are played.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ai.h"
+
+namespace {
+
+struct AiConfig {
+    int depth;
+    Ai::Evaluation evaluation;
+    unsigned time_ms;
+    std::string name;
+};
+
+//one finished game, scores and times from the side of ai a
+struct MatchResult {
+    int game;
+    int a_player;
+    double score;       //1 win, 0.5 draw, 0 loss of ai a
+    std::string moves;  //all moves of the game including the opening, columns 1..7
+    std::vector<long long> times_us[2];
+};
+
+bool parse_config(const std::string &text, AiConfig &config){
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while(std::getline(stream, part, ':')){
+        parts.push_back(part);
+    }
+    if(parts.empty() || parts.size() > 3){
+        return false;
+    }
+    config.depth = std::atoi(parts[0].c_str());
+    config.evaluation = Ai::POSITIONAL;
+    config.time_ms = 0;
+    if(parts.size() > 1){
+        if(parts[1] == "threats"){
+            config.evaluation = Ai::THREATS;
+        }
+        else if(parts[1] != "positional"){
+            return false;
+        }
+    }
+    if(parts.size() > 2){
+        config.time_ms = unsigned(std::atoi(parts[2].c_str()));
+    }
+    config.name = text;
+    return config.depth > 0;
+}
+
+//random opening of game pair index, the same for a seed on every run
+std::string make_opening(unsigned seed, int index, int plies){
+    std::mt19937 rng(seed * 1000003u + unsigned(index));
+    while(true){
+        Board board;
+        int player = 1;
+        std::string moves;
+        bool decided = false;
+        for(int i = 0; i < plies && !decided; ++i){
+            std::vector<int> drops = board.possible_drops();
+            int col = drops[rng() % drops.size()];
+            board.drop(col, player);
+            decided = board.is_winner(player);
+            moves += char('1' + col);
+            player = 3 - player;
+        }
+        if(!decided){
+            return moves;
+        }
+    }
+}
+
+/**
+ * @brief play_game     : plays one game of the tournament
+ * @param game          : index of the game, decides the opening and the colors
+ * @param configs       : settings of ai a and ai b
+ * @param ais           : ais of this worker, side 0 is ai a, side 1 ai b, prepared for the game by new_game
+ * @param seed          : seed of the openings
+ * @param random_plies  : number of random moves of the opening
+ * @return
+ */
+MatchResult play_game(int game, const AiConfig configs[2], std::unique_ptr<Ai> ais[2], unsigned seed, int random_plies){
+    MatchResult record;
+    record.game = game;
+    record.a_player = (game % 2 == 0)? 1 : 2;
+    record.score = 0.5;
+    record.moves = make_opening(seed, game / 2, random_plies);
+
+    Board board;
+    int player = 1;
+    for(char c : record.moves){
+        board.drop(c - '1', player);
+        player = 3 - player;
+    }
+
+    //side 0 is ai a, side 1 ai b, nothing of the last game is kept
+    for(int side = 0; side < 2; ++side){
+        ais[side]->new_game((side == 0)? record.a_player : 3 - record.a_player);
+    }
+
+    while(!board.is_full()){
+        int side = (player == record.a_player)? 0 : 1;
+        auto t_start = std::chrono::steady_clock::now();
+        int col = (configs[side].time_ms > 0)? ais[side]->get_move(board, configs[side].time_ms).first : ais[side]->get_move(board).first;
+        record.times_us[side].push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start).count());
+        board.drop(col, player);
+        record.moves += char('1' + col);
+        if(board.is_winner(player)){
+            record.score = (side == 0)? 1.0 : 0.0;
+            break;
+        }
+        player = 3 - player;
+    }
+    return record;
+}
+
+std::string join_times(const std::vector<long long> &times){
+    std::string text;
+    for(std::size_t i = 0; i < times.size(); ++i){
+        text += (i? ";" : "") + std::to_string(times[i]);
+    }
+    return text;
+}
+
+std::vector<long long> split_times(const std::string &text){
+    std::vector<long long> times;
+    std::stringstream stream(text);
+    std::string item;
+    while(std::getline(stream, item, ';')){
+        times.push_back(std::atoll(item.c_str()));
+    }
+    return times;
+}
+
+const char CSV_HEADER[] = "game,a_player,score,moves,a_times_us,b_times_us";
+
+std::string settings_line(const AiConfig configs[2], int random_plies, unsigned seed){
+    return "# a=" + configs[0].name + " b=" + configs[1].name + " random_plies=" + std::to_string(random_plies)
+            + " seed=" + std::to_string(seed);
+}
+
+/**
+ * @brief read_results  : reads the games of an earlier run with the same settings
+ * @param path          : csv file, may not exist yet
+ * @param settings      : first line the file must have
+ * @param records       : filled with the games
+ * @return              : false if the file exists but belongs to other settings or is broken
+ */
+bool read_results(const std::string &path, const std::string &settings, std::vector<MatchResult> &records){
+    std::ifstream in(path);
+    if(!in){
+        return true;
+    }
+    std::string line;
+    if(!std::getline(in, line) || line != settings || !std::getline(in, line) || line != CSV_HEADER){
+        return false;
+    }
+    while(std::getline(in, line)){
+        if(in.eof()){//no line break, cut off by an interrupted run, the game is played again
+            break;
+        }
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while(std::getline(stream, field, ',')){
+            fields.push_back(field);
+        }
+        if(fields.size() < 4){
+            continue;
+        }
+        fields.resize(6);
+        MatchResult record;
+        record.game = std::atoi(fields[0].c_str());
+        record.a_player = std::atoi(fields[1].c_str());
+        record.score = std::atof(fields[2].c_str());
+        record.moves = fields[3];
+        record.times_us[0] = split_times(fields[4]);
+        record.times_us[1] = split_times(fields[5]);
+        records.push_back(record);
+    }
+    return true;
+}
+
+/**
+ * @brief elo   : Elo difference of a score
+ * @param score : points per game, 0..1
+ * @return
+ */
+double elo(double score){
+    score = std::min(std::max(score, 1e-3), 1.0 - 1e-3);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+long long percentile(std::vector<long long> values, double p){
+    if(values.empty()){
+        return 0;
+    }
+    std::size_t index = std::min(values.size() - 1, std::size_t(p * double(values.size())));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void print_summary(const std::vector<MatchResult> &records, const AiConfig configs[2], bool times){
+    int results[3] = {0, 0, 0};  //wins, draws, losses of ai a
+    double points = 0;
+    double points_squared = 0;
+    for(const auto &r : records){
+        ++results[(r.score > 0.75)? 0 : (r.score > 0.25)? 1 : 2];
+        points += r.score;
+        points_squared += r.score * r.score;
+    }
+    double n = double(std::max<std::size_t>(1, records.size()));
+    double score = points / n;
+    //95% interval of the score mapped to Elo
+    double deviation = std::sqrt(std::max(0.0, points_squared / n - score * score) / n);
+    double low = elo(score - 1.96 * deviation);
+    double high = elo(score + 1.96 * deviation);
+    std::printf("%zu games: %s +%d =%d -%d against %s, score %.1f%%, elo %+.0f (%+.0f .. %+.0f)\n", records.size(),
+                configs[0].name.c_str(), results[0], results[1], results[2], configs[1].name.c_str(), 100.0 * score,
+                elo(score), low, high);
+    if(!times){
+        return;
+    }
+    for(int side = 0; side < 2; ++side){
+        std::vector<long long> all;
+        for(const auto &r : records){
+            all.insert(all.end(), r.times_us[side].begin(), r.times_us[side].end());
+        }
+        long long total = 0;
+        for(long long t : all){
+            total += t;
+        }
+        std::printf("  %s: %zu moves, %.2f ms per move, p99 %.2f ms\n", configs[side].name.c_str(), all.size(),
+                    all.empty()? 0.0 : double(total) / double(all.size()) / 1000.0, double(percentile(all, 0.99)) / 1000.0);
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 4){
+        std::printf("usage: %s <results.csv> <ai_a> <ai_b> [games=1000] [threads=0] [random_plies=4] [seed=1]\n", argv[0]);
+        std::printf("an ai is depth[:positional|threats[:time_ms]], e.g. 8:threats\n");
+        return 1;
+    }
+    std::string path = argv[1];
+    AiConfig configs[2];
+    if(!parse_config(argv[2], configs[0]) || !parse_config(argv[3], configs[1])){
+        std::printf("invalid ai, expected depth[:positional|threats[:time_ms]]\n");
+        return 1;
+    }
+    int games = (argc > 4)? std::atoi(argv[4]) : 1000;
+    int threads = (argc > 5)? std::atoi(argv[5]) : 0;
+    int random_plies = (argc > 6)? std::atoi(argv[6]) : 4;
+    unsigned seed = (argc > 7)? unsigned(std::atoi(argv[7])) : 1;
+    if(threads <= 0){
+        threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    std::string settings = settings_line(configs, random_plies, seed);
+    std::vector<MatchResult> records;
+    if(!read_results(path, settings, records)){
+        std::printf("%s belongs to other settings, expected first line: %s\n", path.c_str(), settings.c_str());
+        return 1;
+    }
+    std::vector<bool> done(games, false);
+    std::vector<MatchResult> kept;
+    for(const auto &r : records){
+        if(r.game >= 0 && r.game < games && !done[r.game]){
+            done[r.game] = true;
+            kept.push_back(r);
+        }
+    }
+    records.swap(kept);
+    std::vector<int> todo;
+    for(int game = 0; game < games; ++game){
+        if(!done[game]){
+            todo.push_back(game);
+        }
+    }
+    if(!records.empty()){
+        std::printf("resuming: %zu games done, %zu to play\n", records.size(), todo.size());
+    }
+
+    //the file is rewritten with the kept games so a cut off last line disappears, through a temporary file
+    //so an interruption never loses games, new games are appended
+    {
+        std::ofstream rewrite(path + ".tmp", std::ios::trunc);
+        rewrite << settings << "\n" << CSV_HEADER << "\n";
+        for(const auto &r : records){
+            rewrite << r.game << "," << r.a_player << "," << r.score << "," << r.moves << ","
+                    << join_times(r.times_us[0]) << "," << join_times(r.times_us[1]) << "\n";
+        }
+        rewrite.close();
+        if(!rewrite || std::rename((path + ".tmp").c_str(), path.c_str()) != 0){
+            std::printf("could not write %s\n", path.c_str());
+            return 1;
+        }
+    }
+    std::ofstream out(path, std::ios::app);
+
+    //one game per worker at a time with the single threaded ais of the worker, they are cleared before every game
+    //so results don't depend on the scheduling
+    std::mutex mutex;
+    std::atomic<std::size_t> next(0);
+    auto t_start = std::chrono::steady_clock::now();
+    std::size_t report_every = std::max<std::size_t>(1, std::size_t(games) / 20);
+    std::vector<std::thread> workers;
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&]{
+            std::unique_ptr<Ai> ais[2];
+            for(int side = 0; side < 2; ++side){
+                ais[side].reset(new Ai(configs[side].depth, 1));
+                ais[side]->set_threads(1);
+                ais[side]->set_evaluation(configs[side].evaluation);
+            }
+            for(std::size_t i = next++; i < todo.size(); i = next++){
+                MatchResult record = play_game(todo[i], configs, ais, seed, random_plies);
+                std::lock_guard<std::mutex> guard(mutex);
+                out << record.game << "," << record.a_player << "," << record.score << "," << record.moves << ","
+                    << join_times(record.times_us[0]) << "," << join_times(record.times_us[1]) << "\n";
+                out.flush();
+                records.push_back(record);
+                if(records.size() % report_every == 0){
+                    print_summary(records, configs, false);
+                    std::fflush(stdout);
+                }
+            }
+        });
+    }
+    for(auto &worker : workers){
+        worker.join();
+    }
+
+    long long seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - t_start).count();
+    std::printf("\n%zu games played in %lld s on %d threads\n", todo.size(), seconds, threads);
+    print_summary(records, configs, true);
+    return 0;
+}
@@ -1,12 +1,19 @@
 #include "form.h"
 #include "ui_form.h"
 
+#include <numeric>
+
+//every game is appended to this file in the working directory, see GameRecord
+static const char RECORD_FILE[] = "connect4.games";
+
 /**
  * @brief Form::Form Constructor for the form class inits default GUI values
  * @param parent inherits from qwidget
  */
 Form::Form(QWidget *parent) : QWidget(parent),
     ui(new Ui::Form),
+    m_txtHelp(nullptr),
+    m_winningLine(nullptr),
 
     m_redBrush(Qt::red),
     m_yelBrush(Qt::yellow),
@@ -17,8 +24,6 @@ Form::Form(QWidget *parent) : QWidget(parent),
 {
     ui->setupUi(this);
 
-    m_txtHelp.reset(new QGraphicsTextItem());
-
     //model graphicsView/scene in it for the game field
     m_scene = std::unique_ptr<QGraphicsScene>(new QGraphicsScene(this));
     ui->graphicsView->setFixedSize(720, 620);
@@ -28,26 +33,26 @@ Form::Form(QWidget *parent) : QWidget(parent),
     ui->graphicsView->fitInView(m_scene->sceneRect(), Qt::KeepAspectRatio);
     ui->graphicsView->setScene(m_scene.get());
 
+    //all items of the scene are created here, the games only change them
+    makelines();
+    makediscs();
+
     // initialization method for general operations
     init();
+    clear_board();
 
-    //fill positions array with zeros
-    std::array<int, 6> dummy;
-    dummy.fill(0);
-    m_positions.fill(dummy);
-
-    //fill possibleDrops array for beginning
-    m_possibleDrops.resize(7);
-    std::iota(m_possibleDrops.begin(), m_possibleDrops.end(), 0);
-
-    //start the timer for GUI updates
-    startTimer();
+    //the observer callbacks come from the threads of the game, the slots update the GUI on its thread
+    connect(this, SIGNAL(boardChanged()), this, SLOT(updateBoard()), Qt::QueuedConnection);
+    connect(this, SIGNAL(progressChanged()), this, SLOT(updateProgress()), Qt::QueuedConnection);
+    connect(this, SIGNAL(gameEnded()), this, SLOT(showGameOver()), Qt::QueuedConnection);
+    connect(this, SIGNAL(logChanged()), this, SLOT(updateLog()), Qt::QueuedConnection);
 }
 
 /**
- * @brief Form::~Form   : destructor to delete ui
+ * @brief Form::~Form   : destructor to stop the game and delete ui, the game cancels its search and joins its worker so no callback comes later
  */
 Form::~Form(){
+    m_game = nullptr;
     delete ui;
 }
 
@@ -78,14 +83,13 @@ void Form::init(){
     ui->lst_out->clear();
 
     //write start hint to scene
-    //    m_txtHelp.reset(new QGraphicsTextItem());
+    m_txtHelp = m_scene->addText("");
     QFont fntHelp = m_txtHelp->font();
     fntHelp.setPixelSize(20);
     m_txtHelp->setFont(fntHelp);
     m_txtHelp->setPos(-150,0);
     m_txtHelp->setPlainText("Choose your settings and click start!");
     m_txtHelp->setTextWidth(400);
-    m_scene->addItem(m_txtHelp.get());
 
     //disable buttons at start
     ui->btn_drop_0->setDisabled(true);
@@ -98,12 +102,34 @@ void Form::init(){
 }
 
 /**
- * @brief Form::startTimer: GUI update timer is started
+ * @brief Form::clear_board: empties the board and hides the items of the last game, the help text is shown again
  */
-void Form::startTimer(){
-    m_updateGuiTimer = std::unique_ptr<QTimer>(new QTimer(this));
-    connect(m_updateGuiTimer.get(), SIGNAL(timeout()), this, SLOT(updateGUI()));
-    m_updateGuiTimer->start(50);
+void Form::clear_board(){
+    {
+        std::lock_guard<std::mutex> guard(m_board_mutex);
+        for(auto &column : m_positions){
+            column.fill(0);
+        }
+        m_possibleDrops.resize(Board::WIDTH);
+        std::iota(m_possibleDrops.begin(), m_possibleDrops.end(), 0);
+        m_game_over = false;
+        m_winner = 0;
+    }
+
+    for(auto &column : m_shown){
+        column.fill(0);
+    }
+    for(auto &column : m_discs){
+        for(auto *disc : column){
+            disc->setVisible(false);
+        }
+    }
+    for(auto *line : m_grid){
+        line->setVisible(false);
+    }
+    m_winningLine->setVisible(false);
+    m_txtHelp->setVisible(true);
+    m_scene->setBackgroundBrush(Qt::white);
 }
 
 /**
@@ -116,7 +142,7 @@ void Form::on_btn_start_clicked()
 
     if(m_p1_is_ai){
         writeToLog("P1: ai");
-        writeToLog("Depth P1: " + QString::number(m_p1_depth));
+        writeToLog("Depth P1: " + std::to_string(m_p1_depth));
     }
     else{
         writeToLog("P1: human");
@@ -124,19 +150,22 @@ void Form::on_btn_start_clicked()
 
     if(m_p2_is_ai){
         writeToLog("P2: ai");
-        writeToLog("Depth P2: " + QString::number(m_p2_depth));
+        writeToLog("Depth P2: " + std::to_string(m_p2_depth));
     }
     else{
         writeToLog("P2: human");
     }
 
-    writeToLog("P" + QString::number(m_p_start) + " starts\n");
+    writeToLog("P" + std::to_string(m_p_start) + " starts\n");
 
 
-    //prepare gui for game, clear scene, enable buttons
+    //prepare gui for game, clear board, show grid, enable buttons
     ui->btn_start->setDisabled(true);
-    m_scene->clear();
-    makelines();
+    clear_board();
+    m_txtHelp->setVisible(false);
+    for(auto *line : m_grid){
+        line->setVisible(true);
+    }
     ui->btn_drop_0->setEnabled(true);
     ui->btn_drop_1->setEnabled(true);
     ui->btn_drop_2->setEnabled(true);
@@ -147,6 +176,10 @@ void Form::on_btn_start_clicked()
 
     //actually generate game and start it
     m_game = std::unique_ptr<Game>(new Game(this, m_p1_is_ai, m_p2_is_ai, m_p1_depth, m_p2_depth, m_p_start));
+    if(!m_game->set_record_file(RECORD_FILE)){
+        writeToLog(std::string("can't write ") + RECORD_FILE);
+    }
+    m_game->set_evaluation(Ai::THREATS);
     m_game->start();
 }
 
@@ -155,12 +188,15 @@ void Form::on_btn_start_clicked()
  */
 void Form::on_btn_reset_clicked()
 {
-    //clear output list
-    ui->lst_out->clear();
+    //stop the game, a running search is cancelled
+    m_game = nullptr;
 
-    //set back board variables of form and positions array
-    m_game_over = false;
-    m_winner = 0;
+    //clear output list and the entries not added yet
+    {
+        std::lock_guard<std::mutex> guard(m_log_mutex);
+        m_log.clear();
+    }
+    ui->lst_out->clear();
 
     //disable buttons at reset
     ui->btn_drop_0->setDisabled(true);
@@ -171,18 +207,8 @@ void Form::on_btn_reset_clicked()
     ui->btn_drop_5->setDisabled(true);
     ui->btn_drop_6->setDisabled(true);
 
-    // clear drawing scene
-    m_scene->clear();
-    m_scene->setBackgroundBrush(Qt::white);
-
-    //fill positions array with zeros
-    std::array<int, 6> dummy;
-    dummy.fill(0);
-    m_positions.fill(dummy);
-
-    //fill possibleDrops array for beginning
-    m_possibleDrops.resize(7);
-    std::iota(m_possibleDrops.begin(), m_possibleDrops.end(), 0);
+    //set back board variables of form and the items of the scene
+    clear_board();
 
     //disable start button
     ui->btn_start->setDisabled(false);
@@ -193,10 +219,19 @@ void Form::on_btn_reset_clicked()
  * @param pos position [0,6] to drop the coin
  */
 void Form::save_drop(int pos){
+    //no game before start and after game over
+    if(!m_game){
+        return;
+    }
     //check for validity
     if(((m_game->get_current_player() == 1 && !m_p1_is_ai) || (m_game->get_current_player() == 2 && !m_p2_is_ai)) && !m_game->game_over){
         bool flag = false;
-        for(auto i: m_possibleDrops){
+        std::vector<int> possibleDrops;
+        {
+            std::lock_guard<std::mutex> guard(m_board_mutex);
+            possibleDrops = m_possibleDrops;
+        }
+        for(auto i: possibleDrops){
             if(i == pos){
                 flag=true;
             }
@@ -207,7 +242,7 @@ void Form::save_drop(int pos){
             m_game->human_move(pos);
         }
         else{//don't execute the move and write this to output list
-            writeToLog("P" + QString::number(m_game->get_current_player()) + " : " + QString::number(pos) + " - invalid");
+            writeToLog("P" + std::to_string(m_game->get_current_player()) + " : " + std::to_string(pos) + " - invalid");
             writeToLog("------------------");
         }
     }
@@ -232,103 +267,215 @@ void Form::on_rdbtn_start_p2_toggled(bool checked){m_p_start = checked? 2 : 1;}
 void Form::on_cmbb_difficulty_1_currentIndexChanged(int index){m_p1_depth = index+1;}
 void Form::on_cmbb_difficulty_2_currentIndexChanged(int index){m_p2_depth = index+1;}
 
-//draw the board
+//draw the board, hidden until a game starts
 void Form::makelines(){
     //draw vertical lines of board
-    m_scene->addLine(-350,300,-350,-300,m_borderPen);
-    m_scene->addLine(-250,300,-250,-300,m_borderPen);
-    m_scene->addLine(-150,300,-150,-300,m_borderPen);
-    m_scene->addLine(-50,300,-50,-300,m_borderPen);
-    m_scene->addLine(50,300,50,-300,m_borderPen);
-    m_scene->addLine(150,300,150,-300,m_borderPen);
-    m_scene->addLine(250,300,250,-300,m_borderPen);
-    m_scene->addLine(350,300,350,-300,m_borderPen);
+    for(int i = 0; i <= Board::WIDTH; ++i){
+        m_grid.push_back(m_scene->addLine(-350 + (100 * i), 300, -350 + (100 * i), -300, m_borderPen));
+    }
 
     //draw horizontal lines of board
-    m_scene->addLine(-350, -300, 350, -300, m_dashedPen);
-    m_scene->addLine(-350, -200, 350, -200, m_dashedPen);
-    m_scene->addLine(-350, -100, 350, -100, m_dashedPen);
-    m_scene->addLine(-350, -000, 350, -000, m_dashedPen);
-    m_scene->addLine(-350, 100, 350, 100, m_dashedPen);
-    m_scene->addLine(-350, 200, 350, 200, m_dashedPen);
-    m_scene->addLine(-350, 300, 350, 300, m_dashedPen);
+    for(int j = 0; j <= Board::HEIGHT; ++j){
+        m_grid.push_back(m_scene->addLine(-350, -300 + (100 * j), 350, -300 + (100 * j), m_dashedPen));
+    }
+}
+
+//one disc per cell and the winning line, hidden until they are needed
+void Form::makediscs(){
+    for(int i = 0; i < Board::WIDTH; ++i){
+        for(int j = 0; j < Board::HEIGHT; ++j){
+            m_discs[i][j] = m_scene->addEllipse(-340 + (100*i), -290 + (100 * j), 80, 80, m_borderPen, Qt::NoBrush);
+        }
+    }
+    m_winningLine = m_scene->addLine(0, 0, 0, 0, QPen{10});
 }
 
 /*
  * Methods called by the observer as callback from game
  */
 void Form::updatePositions(boardarray positions){
-    //update positions from game
-    m_positions = positions;
+    //update positions from game, the discs are changed on the GUI thread
+    {
+        std::lock_guard<std::mutex> guard(m_board_mutex);
+        m_positions = positions;
+    }
+    emit boardChanged();
 }
 
 void Form::updatePossibleDrops(std::vector<int> possibleDrops){
     //update possible drops from game
+    std::lock_guard<std::mutex> guard(m_board_mutex);
     m_possibleDrops = possibleDrops;
 }
 
-void Form::writeToLog(QString item){
-    //add list entry and scroll to bottom
-    ui->lst_out->addItem(item);
+void Form::writeToLog(std::string item){
+    //queue the list entry, updateLog adds it on the GUI thread
+    {
+        std::lock_guard<std::mutex> guard(m_log_mutex);
+        m_log.push_back(item);
+    }
+    emit logChanged();
+}
+
+void Form::updateSearchStats(int, SearchStats stats){
+    //the move is done, remove its live analysis
+    {
+        std::lock_guard<std::mutex> guard(m_progress_mutex);
+        m_progress.clear();
+    }
+    emit progressChanged();
+
+    //show the statistics of the last ai move below its time
+    if(stats.book){
+        writeToLog("book move");
+        return;
+    }
+    if(stats.pondered){
+        writeToLog("pondered move");
+    }
+    writeToLog("nodes: " + std::to_string(stats.nodes) + " (" + std::to_string(stats.nodes * 1000 / std::max(1LL, stats.time_us)) + " knps)");
+    if(stats.thread_nodes.size() > 1){
+        std::string threads = "threads:";
+        for(uint64_t nodes : stats.thread_nodes){
+            threads += " " + std::to_string(nodes);
+        }
+        writeToLog(threads);
+    }
+    if(SearchStats::COUNTERS){
+        writeToLog("evals: " + std::to_string(stats.leaf_evals) + ", tt cutoffs: " + std::to_string(stats.tt_cutoffs));
+        writeToLog("cutoffs: " + std::to_string(stats.beta_cutoffs) + " ("
+                   + std::to_string(int(stats.first_move_cutoff_rate() * 100)) + "% first move)");
+        writeToLog("max ply: " + std::to_string(stats.max_ply));
+    }
+}
+
+void Form::updateSearchProgress(int player, SearchProgress progress){
+    //keep the current best move and variation, updateProgress shows it
+    std::string text = "P" + std::to_string(player) + " thinking: depth " + std::to_string(progress.depth)
+            + (progress.complete? "" : "*") + ", best " + std::to_string(progress.move)
+            + ", score " + std::to_string(progress.score) + ", pv";
+    for(int col : progress.pv){
+        text += " " + std::to_string(col);
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_progress_mutex);
+        m_progress = text;
+    }
+    emit progressChanged();
 }
 
 void Form::gameOver(int winningPlayer){
     //update game over and winner parameter
-    m_game_over = true;
-    m_winner = winningPlayer;
+    {
+        std::lock_guard<std::mutex> guard(m_board_mutex);
+        m_game_over = true;
+        m_winner = winningPlayer;
+        m_winner_line = std::make_pair(std::make_pair(-1, -1), std::make_pair(-1, -1));
+    }
+    emit gameEnded();
 }
 
 void Form::setWinningLine(std::pair<std::pair<int, int>, std::pair<int, int>> winningLine){
-    //set winning line for drawing
-    m_winner_line = winningLine;
+    //set winning line for drawing, it comes after gameOver
+    {
+        std::lock_guard<std::mutex> guard(m_board_mutex);
+        m_winner_line = winningLine;
+    }
+    emit gameEnded();
 }
 
 /**
- * @brief Form::updateGUI: Called by timer event to update GUI
+ * @brief Form::updateBoard: Called after a move, changes the discs of the cells which changed since the last call
  */
-void Form::updateGUI(){
+void Form::updateBoard(){
+    boardarray positions;
+    {
+        std::lock_guard<std::mutex> guard(m_board_mutex);
+        positions = m_positions;
+    }
 
-    ui->lst_out->scrollToBottom();
-    //draw the coins
-    for(int i = 0; i < 7; ++i){
-        for(int j = 0; j < 6; ++j){
-            if(m_positions[i][j] == 1){// 1 = yellow player
-                m_scene->addEllipse(-340 + (100*i), -290 + (100 * j), 80, 80, m_borderPen, m_yelBrush);
+    for(int i = 0; i < Board::WIDTH; ++i){
+        for(int j = 0; j < Board::HEIGHT; ++j){
+            if(positions[i][j] == m_shown[i][j]){
+                continue;
+            }
+            m_shown[i][j] = positions[i][j];
+            if(positions[i][j] == 1){// 1 = yellow player
+                m_discs[i][j]->setBrush(m_yelBrush);
             }
-            else if (m_positions[i][j] == 2) {// 2 = red player
-                m_scene->addEllipse(-340 + (100*i), -290 + (100 * j), 80, 80, m_borderPen, m_redBrush);
+            else if(positions[i][j] == 2){// 2 = red player
+                m_discs[i][j]->setBrush(m_redBrush);
             }
+            m_discs[i][j]->setVisible(positions[i][j] != 0);
         }
     }
+}
 
-    //routine if game is over
-    if(m_game_over){
-        m_game = nullptr;
-        //gray out background
-        m_scene->setBackgroundBrush(Qt::gray);
-
-        //disable buttons at game over
-        ui->btn_drop_0->setDisabled(true);
-        ui->btn_drop_1->setDisabled(true);
-        ui->btn_drop_2->setDisabled(true);
-        ui->btn_drop_3->setDisabled(true);
-        ui->btn_drop_4->setDisabled(true);
-        ui->btn_drop_5->setDisabled(true);
-        ui->btn_drop_6->setDisabled(true);
-
-        if(m_winner != 0){
-            //define winning line (the 4 connected coins)
-            int st_x = -300 + (100 * m_winner_line.first.first);
-            int st_y = -250 + (100 * m_winner_line.first.second);
-            int en_x = -300 + (100 * m_winner_line.second.first);
-            int en_y = -250 + (100 * m_winner_line.second.second);
-            QPen pen{10};
-
-            //draw winning line
-            m_scene->addLine(st_x, st_y, en_x, en_y, pen);
+/**
+ * @brief Form::updateLog: Called after log entries were written, adds them to the output list and scrolls to bottom
+ */
+void Form::updateLog(){
+    std::vector<std::string> log;
+    {
+        std::lock_guard<std::mutex> guard(m_log_mutex);
+        log.swap(m_log);
+    }
+    if(log.empty()){//already added by an earlier call
+        return;
+    }
+    for(const std::string &item : log){
+        ui->lst_out->addItem(QString::fromStdString(item));
+    }
+    ui->lst_out->scrollToBottom();
+}
+
+/**
+ * @brief Form::updateProgress: Called when the live analysis of a running search changed, shows it in the window title
+ */
+void Form::updateProgress(){
+    std::lock_guard<std::mutex> guard(m_progress_mutex);
+    setWindowTitle(QString::fromStdString(m_progress.empty()? "connect4" : "connect4 - " + m_progress));
+}
+
+/**
+ * @brief Form::showGameOver: Called when the game is over and again when its winning line is known
+ */
+void Form::showGameOver(){
+    int winner;
+    std::pair<std::pair<int, int>, std::pair<int, int>> winner_line;
+    {
+        std::lock_guard<std::mutex> guard(m_board_mutex);
+        if(!m_game_over){//the game was reset meanwhile
+            return;
         }
+        winner = m_winner;
+        winner_line = m_winner_line;
     }
 
+    //deleting the game joins its worker, which has nothing left to send but the winning line. Queued events of the
+    //game only read the stored state: updateBoard never uses m_game and the second gameEnded finds it already gone
+    m_game = nullptr;
+    //gray out background
+    m_scene->setBackgroundBrush(Qt::gray);
 
-}
+    //disable buttons at game over
+    ui->btn_drop_0->setDisabled(true);
+    ui->btn_drop_1->setDisabled(true);
+    ui->btn_drop_2->setDisabled(true);
+    ui->btn_drop_3->setDisabled(true);
+    ui->btn_drop_4->setDisabled(true);
+    ui->btn_drop_5->setDisabled(true);
+    ui->btn_drop_6->setDisabled(true);
+
+    if(winner != 0 && winner_line.first.first >= 0){
+        //define winning line (the 4 connected coins)
+        int st_x = -300 + (100 * winner_line.first.first);
+        int st_y = -250 + (100 * winner_line.first.second);
+        int en_x = -300 + (100 * winner_line.second.first);
+        int en_y = -250 + (100 * winner_line.second.second);
 
+        //draw winning line
+        m_winningLine->setLine(st_x, st_y, en_x, en_y);
+        m_winningLine->setVisible(true);
+    }
+}
@@ -3,10 +3,12 @@
 
 #include <QWidget>
 #include <QString>
-#include <QTimer>
 #include <QGraphicsScene>
 #include <QGraphicsItem>
 
+#include <array>
+#include <mutex>
+
 #include "board.h"
 #include "game.h"
 
@@ -19,11 +21,15 @@ class Form;
 
 /**
  * @brief The Form class contains all handles for the GUI and is the only class interacting with it
+ *
+ * The scene is built once: the grid, one disc item per cell, the winning line and the help text. The observer
+ * callbacks of the game only store the new state and emit a signal, the queued slots on the GUI thread then
+ * change the brush or visibility of the items whose cell changed, so the scene never grows.
  */
 class Form : public QWidget, public Observer
 {
     Q_OBJECT
-    using boardarray = std::array<std::array<int, 6>, 7>;
+    using boardarray = Board::boardarray;
 
 public:
     explicit Form(QWidget *parent = nullptr);
@@ -34,9 +40,12 @@ private:
     Ui::Form* ui;
     std::unique_ptr<QGraphicsScene> m_scene;
     std::unique_ptr<Game> m_game;
-    std::unique_ptr<QTimer> m_updateGuiTimer;
-    std::unique_ptr<QGraphicsTextItem> m_txtHelp;
-    std::unique_ptr<QGraphicsTextItem> m_txtGameOver;
+
+    //items of the scene, owned by it
+    QGraphicsTextItem *m_txtHelp;
+    std::vector<QGraphicsLineItem *> m_grid;
+    std::array<std::array<QGraphicsEllipseItem *, Board::HEIGHT>, Board::WIDTH> m_discs;
+    QGraphicsLineItem *m_winningLine;
 
     QBrush m_redBrush;
     QBrush m_yelBrush;
@@ -44,15 +53,18 @@ private:
     QPen m_dashedPen;
 
     void init();
-    void startTimer();
     void enable_columns();
     void disable_columns();
     void save_drop(int pos);
     void makelines();
+    void makediscs();
+    void clear_board();
 
     virtual void updatePositions(boardarray positions) override;
     virtual void updatePossibleDrops(std::vector<int> possibleDrops) override;
-    virtual void writeToLog(QString item) override;
+    virtual void writeToLog(std::string item) override;
+    virtual void updateSearchStats(int player, SearchStats stats) override;
+    virtual void updateSearchProgress(int player, SearchProgress progress) override;
     virtual void gameOver(int winningPlayer) override;
     virtual void setWinningLine(std::pair<std::pair<int, int>, std::pair<int, int>> winningLine) override;
 
@@ -63,13 +75,31 @@ private:
     int m_p2_depth;
     int m_p_start;
 
-    //board variables during game
+    //board variables during game, written by the game, read by the slots on the GUI thread
+    std::mutex m_board_mutex;
     boardarray m_positions;
     bool m_game_over;
     int m_winner;
     std::pair<std::pair<int, int>, std::pair<int, int>> m_winner_line;
     std::vector<int> m_possibleDrops;
 
+    //positions the disc items show, only used on the GUI thread
+    boardarray m_shown;
+
+    //live analysis of the running search, written by the search thread, shown in the window title
+    std::mutex m_progress_mutex;
+    std::string m_progress;
+
+    //log entries written by the game, added to the output list on the GUI thread
+    std::mutex m_log_mutex;
+    std::vector<std::string> m_log;
+
+signals:
+    void boardChanged();
+    void progressChanged();
+    void gameEnded();
+    void logChanged();
+
 private slots:
     void on_btn_drop_0_clicked();
     void on_btn_drop_1_clicked();
@@ -90,7 +120,10 @@ private slots:
     void on_rdbtn_p2_human_toggled(bool checked);
     void on_rdbtn_start_p1_toggled(bool checked);
     void on_rdbtn_start_p2_toggled(bool checked);
-    void updateGUI();
+    void updateBoard();
+    void updateProgress();
+    void showGameOver();
+    void updateLog();
 };
 
 #endif // FORM_H
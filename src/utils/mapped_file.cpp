@@ -0,0 +1,126 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief MappedFile::MappedFile    : creates a closed mapping
+ */
+MappedFile::MappedFile():
+    m_data(nullptr),
+    m_size(0)
+#if defined(_WIN32)
+    , m_file(nullptr),
+    m_mapping(nullptr)
+#endif
+{}
+
+/**
+ * @brief MappedFile::~MappedFile   : unmaps the file
+ */
+MappedFile::~MappedFile(){
+    close();
+}
+
+/**
+ * @brief MappedFile::open  : maps the file at path, an open mapping is closed first
+ * @param path              : file to map
+ * @return                  : true on success, empty files can't be mapped
+ */
+bool MappedFile::open(const std::string &path){
+    close();
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0){
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping == nullptr){
+        CloseHandle(file);
+        return false;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(data == nullptr){
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const unsigned char *>(data);
+    m_size = std::size_t(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0){
+        ::close(fd);
+        return false;
+    }
+    void *data = mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);//the mapping keeps the file alive
+    if(data == MAP_FAILED){
+        return false;
+    }
+    m_data = static_cast<const unsigned char *>(data);
+    m_size = std::size_t(st.st_size);
+#endif
+    return true;
+}
+
+/**
+ * @brief MappedFile::close : unmaps the file
+ */
+void MappedFile::close(){
+    if(m_data == nullptr){
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+/**
+ * @brief MappedFile::is_open   : true if a file is mapped
+ * @return
+ */
+bool MappedFile::is_open() const{
+    return m_data != nullptr;
+}
+
+/**
+ * @brief MappedFile::data  : first byte of the mapped file
+ * @return
+ */
+const unsigned char *MappedFile::data() const{
+    return m_data;
+}
+
+/**
+ * @brief MappedFile::size  : size of the mapped file in bytes
+ * @return
+ */
+std::size_t MappedFile::size() const{
+    return m_size;
+}
@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief The MappedFile class maps a whole file read-only into memory, pages are loaded by the os on first access
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    bool is_open() const;
+    const unsigned char *data() const;
+    std::size_t size() const;
+
+private:
+    const unsigned char *m_data;
+    std::size_t m_size;
+#if defined(_WIN32)
+    void *m_file;
+    void *m_mapping;
+#endif
+};
+
+#endif // MAPPED_FILE_H
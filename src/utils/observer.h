@@ -1,18 +1,26 @@
 #ifndef OBSERVER_H
 #define OBSERVER_H
 
-#include <QString>
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "search_stats.h"
 
 
 class Observer
 {
-    using boardarray = std::array<std::array<int, 6>, 7>;
+    using boardarray = Board::boardarray;
 
 public:
     virtual ~Observer(){}
     virtual void updatePositions(boardarray positions) = 0;
     virtual void updatePossibleDrops(std::vector<int> possibleDrops) = 0;
-    virtual void writeToLog(QString item) = 0;
+    virtual void writeToLog(std::string item) = 0;
+    virtual void updateSearchStats(int player, SearchStats stats) = 0;
+    virtual void updateSearchProgress(int player, SearchProgress progress) = 0;
     virtual void gameOver(int winningPlayer) = 0;
     virtual void setWinningLine(std::pair<std::pair<int, int>, std::pair<int, int>> winningLine) = 0;
 };
@@ -0,0 +1,57 @@
+#ifndef STOP_TOKEN_H
+#define STOP_TOKEN_H
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief The StopToken class is the observing side of a cancellation request, cheap to copy and to poll
+ *
+ * A default constructed token is never stopped. Tokens of a StopSource share its flag, so a task holding a
+ * token can still poll it after the source is gone.
+ */
+class StopToken
+{
+public:
+    StopToken() = default;
+
+    bool stop_requested() const{
+        return m_state && m_state->load(std::memory_order_relaxed);
+    }
+
+    bool stop_possible() const{
+        return static_cast<bool>(m_state);
+    }
+
+private:
+    friend class StopSource;
+    explicit StopToken(std::shared_ptr<std::atomic<bool>> state): m_state(std::move(state)){}
+
+    std::shared_ptr<std::atomic<bool>> m_state;
+};
+
+/**
+ * @brief The StopSource class requests the cancellation of everything holding one of its tokens
+ */
+class StopSource
+{
+public:
+    StopSource(): m_state(std::make_shared<std::atomic<bool>>(false)){}
+
+    StopToken get_token() const{
+        return StopToken(m_state);
+    }
+
+    void request_stop(){
+        m_state->store(true);
+    }
+
+    bool stop_requested() const{
+        return m_state->load();
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_state;
+};
+
+#endif // STOP_TOKEN_H
@@ -0,0 +1,142 @@
+#include "thread_pool.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief ThreadPool::instance  : returns the pool of the process, started with one worker per core on first use
+ * @return
+ */
+ThreadPool &ThreadPool::instance(){
+    static ThreadPool pool;
+    return pool;
+}
+
+/**
+ * @brief ThreadPool::ThreadPool    : starts one unpinned worker per core
+ */
+ThreadPool::ThreadPool():
+    m_stopping(false),
+    m_pinned(false)
+{
+    start(0, false);
+}
+
+/**
+ * @brief ThreadPool::~ThreadPool   : stops and joins all workers
+ */
+ThreadPool::~ThreadPool(){
+    shutdown();
+}
+
+/**
+ * @brief ThreadPool::configure : restarts the pool with a new number of workers, must not be called from a worker
+ * @param workers               : number of workers, 0 for one per core
+ * @param pin_threads           : pins worker i to core i (linux only)
+ */
+void ThreadPool::configure(int workers, bool pin_threads){
+    shutdown();
+    start(workers, pin_threads);
+}
+
+/**
+ * @brief ThreadPool::submit    : queues a task for the next free worker
+ * @param task                  : task to run
+ * @return                      : future which is ready when the task finished, broken if the pool shut down before
+ */
+std::future<void> ThreadPool::submit(std::function<void()> task){
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_tasks.push_back(std::move(packaged));
+    }
+    m_wakeup.notify_one();
+    return result;
+}
+
+/**
+ * @brief ThreadPool::shutdown  : lets running tasks finish, drops queued ones and joins all workers
+ */
+void ThreadPool::shutdown(){
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_all();
+    for(auto &worker : m_workers){
+        if(worker.joinable()){
+            worker.join();
+        }
+    }
+    m_workers.clear();
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_tasks.clear();
+}
+
+/**
+ * @brief ThreadPool::get_workers   : number of workers
+ * @return
+ */
+int ThreadPool::get_workers() const{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return int(m_workers.size());
+}
+
+/**
+ * @brief ThreadPool::is_pinned : true if the workers are pinned to cores
+ * @return
+ */
+bool ThreadPool::is_pinned() const{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_pinned;
+}
+
+/**
+ * @brief ThreadPool::start : starts the workers
+ * @param workers           : number of workers, 0 for one per core
+ * @param pin_threads       : pins worker i to core i (linux only)
+ */
+void ThreadPool::start(int workers, bool pin_threads){
+    int cores = int(std::max(1u, std::thread::hardware_concurrency()));
+    if(workers <= 0){
+        workers = cores;
+    }
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_stopping = false;
+    m_pinned = pin_threads;
+    for(int i = 0; i < workers; ++i){
+        m_workers.emplace_back(&ThreadPool::worker_loop, this);
+#if defined(__linux__)
+        if(pin_threads){
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % cores, &cpus);
+            pthread_setaffinity_np(m_workers.back().native_handle(), sizeof(cpu_set_t), &cpus);
+        }
+#endif
+    }
+}
+
+/**
+ * @brief ThreadPool::worker_loop   : runs queued tasks until the pool shuts down
+ */
+void ThreadPool::worker_loop(){
+    while(true){
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait(lock, [this]{return m_stopping || !m_tasks.empty();});
+            if(m_stopping){
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
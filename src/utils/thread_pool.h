@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The ThreadPool class is the process-wide set of worker threads the searches and games run their tasks on
+ *
+ * Workers are started once and reused across moves and games. A task must not block waiting for another task
+ * of the pool which might still be queued, since all workers could be busy.
+ */
+class ThreadPool
+{
+public:
+    static ThreadPool &instance();
+
+    void configure(int workers, bool pin_threads);
+    std::future<void> submit(std::function<void()> task);
+    void shutdown();
+
+    int get_workers() const;
+    bool is_pinned() const;
+
+private:
+    ThreadPool();
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void start(int workers, bool pin_threads);
+    void worker_loop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::packaged_task<void()>> m_tasks;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    bool m_stopping;
+    bool m_pinned;
+};
+
+#endif // THREAD_POOL_H